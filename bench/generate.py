@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Generates synthetic Minor C programs of a given shape and size, for
+measuring how fast translate is on each kind of input."""
+
+import argparse
+import random
+import sys
+
+OPERATORS = ['+', '-', '*', '&', '|', '^', '<<', '>>']
+COMPARISONS = ['<', '>', '==', '!=', '<=', '>=']
+
+
+def prototypes(out):
+    out.write('fn mix(a `i32, b `i32) `i32.\n')
+    out.write('fn next(a `i32) `i32.\n')
+
+
+def operand(rng, names):
+    r = rng.random()
+    if r < 0.6:
+        return rng.choice(names)
+    if r < 0.8:
+        return '%di32' % rng.randint(0, 1000)
+    if r < 0.9:
+        return 'next(%s)' % rng.choice(names)
+    return 'mix(%s, %s)' % (rng.choice(names), rng.choice(names))
+
+
+def small_fns(out, rng, size):
+    """Many functions with a few short statements each."""
+    i = 0
+    while out.tell() < size:
+        out.write('fn small%d(x `i32, y `i32) `i32 {\n' % i)
+        out.write('  z = x %s y\n' % rng.choice(OPERATORS))
+        out.write('  if z %s %s\n' % (rng.choice(COMPARISONS), operand(rng, ['x', 'y'])))
+        out.write('    z = next(z)\n')
+        out.write('  end\n')
+        out.write('  return z + %s\n' % operand(rng, ['x', 'y', 'z']))
+        out.write('}\n')
+        i = i + 1
+
+
+def huge_fns(out, rng, size):
+    """Few functions, each with tens of thousands of statements."""
+    names = ['v%d' % i for i in range(64)]
+    i = 0
+    while out.tell() < size:
+        out.write('fn huge%d(x `i32) `i32 {\n' % i)
+        for name in names:
+            out.write('  %s = x\n' % name)
+        for _ in range(20000):
+            out.write('  %s = %s %s %s\n' % (rng.choice(names), operand(rng, names), rng.choice(OPERATORS), operand(rng, names)))
+        out.write('  return %s\n}\n' % names[0])
+        i = i + 1
+
+
+def deep_expression(rng, depth):
+    if depth == 0:
+        return operand(rng, ['x', 'y'])
+    inner = deep_expression(rng, depth - 1)
+    r = rng.random()
+    if r < 0.4:
+        return '(%s %s y)' % (inner, rng.choice(OPERATORS))
+    if r < 0.7:
+        return 'next(%s)' % inner
+    return 'mix(x, %s)' % inner
+
+
+def deep_expressions(out, rng, size):
+    """Expressions nested a hundred levels deep, in parentheses and calls."""
+    i = 0
+    while out.tell() < size:
+        out.write('fn deep%d(x `i32, y `i32) `i32 {\n' % i)
+        out.write('  return %s\n}\n' % deep_expression(rng, 100))
+        i = i + 1
+
+
+def operator_chains(out, rng, size):
+    """Long chains of binary operators and casts between them."""
+    names = ['a', 'b', 'c', 'd']
+    i = 0
+    while out.tell() < size:
+        out.write('fn chain%d(a `i32, b `i32, c `i32, d `i32) `i32 {\n' % i)
+        for _ in range(8):
+            terms = [operand(rng, names)]
+            for _ in range(rng.randint(50, 250)):
+                term = operand(rng, names)
+                if rng.random() < 0.2:
+                    term = '%s@`i64@`i32' % term
+                terms.append('%s %s' % (rng.choice(OPERATORS), term))
+            out.write('  a = %s\n' % ' '.join(terms))
+        out.write('  return a\n}\n')
+        i = i + 1
+
+
+def declarations(out, rng, size):
+    """Structs and constants, with array lengths that use the constants, and
+    function prototypes. All the structs together have fewer fields than the
+    compiler keeps, so past that there are only constants and prototypes."""
+    i = 0
+    while out.tell() < size:
+        out.write('const length%d = %d\n' % (i, rng.randint(1, 64)))
+        if i < 6000:
+            fields = ['  f%d `%s' % (j, rng.choice(['i32', 'u8*', 'u64[length%d]' % i, 'item%d*' % i])) for j in range(rng.randint(2, 8))]
+            out.write('struct item%d\n%s;\n' % (i, ',\n'.join(fields)))
+        else:
+            out.write('fn prototype%d(a `i32, b `u8*) `i32.\n' % i)
+        i = i + 1
+
+
+def identifiers(out, rng, size):
+    """Long, mostly distinct names, so that interning dominates."""
+    i = 0
+    letters = 'abcdefghijklmnopqrstuvwxyz_'
+    while out.tell() < size:
+        names = ['n' + ''.join(rng.choice(letters) for _ in range(rng.randint(12, 40))) + '%d' % i for _ in range(16)]
+        out.write('fn named_function_with_a_long_name_%d(%s `i32) `i32 {\n' % (i, names[0]))
+        for j in range(1, len(names)):
+            out.write('  %s = %s + %s\n' % (names[j], names[j - 1], names[rng.randrange(j)]))
+        out.write('  return %s\n}\n' % names[-1])
+        i = i + 1
+
+
+CORPORA = {
+    'small-fns': small_fns,
+    'huge-fns': huge_fns,
+    'deep-expressions': deep_expressions,
+    'operator-chains': operator_chains,
+    'declarations': declarations,
+    'identifiers': identifiers,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('corpus', choices=sorted(CORPORA))
+    parser.add_argument('output')
+    parser.add_argument('--megabytes', type=float, default=16, help='approximate size of the program')
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+    rng = random.Random(args.seed)
+    with open(args.output, 'w') as out:
+        prototypes(out)
+        CORPORA[args.corpus](out, rng, int(args.megabytes * 1000000))
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,44 @@
+#!/usr/bin/env sh
+
+# Translates each synthetic corpus a few times with '-t', and appends the
+# phase timings of the fastest run to a tab-separated file, one row per phase,
+# tagged with the commit, so that runs across commits can be compared.
+#
+# Usage: bench/run_benchmarks.sh [results.tsv]
+# MEGABYTES, RUNS and MAIN can be set in the environment.
+
+set -eu
+
+cd $(dirname $0)
+RESULTS=${1:-results.tsv}
+MEGABYTES=${MEGABYTES:-16}
+RUNS=${RUNS:-5}
+MAIN=${MAIN:-$(pwd)/../src/main}
+COMMIT=$(git rev-parse --short HEAD)$(git diff --quiet HEAD -- ../src || echo -dirty)
+CORPORA="small-fns huge-fns deep-expressions operator-chains declarations identifiers"
+
+mkdir -p corpora
+if [ ! -f "$RESULTS" ]; then
+  printf 'commit\tcorpus\tphase\tseconds\tMB/s\tdeclarations/s\n' > "$RESULTS"
+fi
+
+for corpus in $CORPORA; do
+  input=corpora/$corpus-$MEGABYTES.minc
+  if [ ! -f "$input" ]; then
+    ./generate.py $corpus "$input" --megabytes $MEGABYTES
+  fi
+  best=
+  run=0
+  while [ $run -lt $RUNS ]; do
+    "$MAIN" translate -t "$input" 2> corpora/timings.tsv > /dev/null
+    total=$(awk -F '\t' '$1 == "total" { print $2 }' corpora/timings.tsv)
+    if [ -z "$best" ] || awk "BEGIN { exit !($total < $best) }"; then
+      best=$total
+      cp corpora/timings.tsv corpora/best.tsv
+    fi
+    run=$((run + 1))
+  done
+  tail -n +2 corpora/best.tsv | sed "s/^/$COMMIT\t$corpus\t/" >> "$RESULTS"
+  printf '%s\t%s s\n' $corpus $best
+done
+rm -f corpora/timings.tsv corpora/best.tsv
@@ -0,0 +1,53 @@
+typedef signed char i8;
+typedef unsigned char u8;
+typedef signed short i16;
+typedef unsigned short u16;
+typedef signed int i32;
+typedef unsigned int u32;
+typedef signed long i64;
+typedef unsigned long u64;
+typedef unsigned long size;
+typedef float f32;
+typedef double f64;
+
+void* syscall5(void* number, void* arg1, void* arg2, void* arg3, void* arg4, void* arg5);
+
+void* syscall4(void* number, void* arg1, void* arg2, void* arg3, void* arg4);
+
+void* syscall3(void* number, void* arg1, void* arg2, void* arg3);
+
+void* syscall2(void* number, void* arg1, void* arg2);
+
+void* syscall1(void* number, void* arg1);
+
+i64 syscall_read(i32 fd, void* data, u64 nbytes) {
+  return (i64)syscall3((void*)(u64)0ul, (void*)(i64)fd, data, (void*)nbytes);
+}
+
+i64 syscall_write(i32 fd, void* data, u64 nbytes) {
+  return (i64)syscall3((void*)(u64)1ul, (void*)(i64)fd, data, (void*)nbytes);
+}
+
+i64 syscall_open(char* filename, u64 flags, u64 mode) {
+  return (i64)syscall3((void*)(u64)2ul, (void*)filename, (void*)(i64)flags, (void*)(i64)mode);
+}
+
+i64 syscall_exit(i32 status) {
+  return (i64)syscall1((void*)(u64)60ul, (void*)(i64)status);
+}
+
+u64 min_size(u64 a, u64 b) {
+  if (a < b) {
+    return a;
+  } else {
+    return b;
+  }
+}
+
+bool string_equal(char* expected, char* actual) {
+  u64 i;
+  i = (u64)0ul;
+  while (1) {
+    i = i + (u64)1ul;
+  }
+}
@@ -5,19 +5,55 @@
  * we put all the constants in one place.
  * -------------------------------------------------------------------------------- */
 
-#define ONE_MB 10485760
+#define ONE_MB 1048576
 #define TEN_MB 10485760 
 #define HUNDRED_MB 104857600
 #define MAX_U16 65536
-#define PARSE_READ_BUFFER_CAPACITY TEN_MB
 #define MAX_LINE_LENGTH_FOR_ERRORS 120
-#define STRINGS_ID_MAP_LENGTH MAX_U16
-#define EXPRESSION_PARSING_RECURSION_LIMIT 255
+/* The defaults of the limits that can be changed with '-l'. */
+#define MAX_STRINGS 1048576
+/* The keywords, operators and type names that take the first string ids,
+   which the strings limit can't be lower than. */
+#define BUILTIN_STRINGS_COUNT 40
 #define MAX_STRINGS_DATA HUNDRED_MB
+#define MAX_EXPRESSIONS TEN_MB
+#define MAX_EXPRESSION_NESTING ONE_MB
+#define MAX_FN_ARGUMENTS TEN_MB
+/* Each thread copies the strings it adds into a region of this many bytes at a
+   time. */
+#define STRINGS_REGION_LENGTH 16384
 #define MAX_STRUCT_FIELDS MAX_U16
 #define MAX_ARRAY_LENGTHS MAX_U16
 #define MAX_LOCAL_VARIABLES 1024
-#define MAX_EXPRESSIONS TEN_MB
+#define MAX_OPERATOR_CHAIN_LENGTH 255
+/* Calls keep their number of arguments in a byte. */
+#define MAX_ARITY 255
+#define MAX_STATEMENTS MAX_U16
+#define MAX_BLOCK_DEPTH 1024
+#define MAX_TYPE_MODIFIERS 8
+#define EMIT_BUFFER_CAPACITY ONE_MB
+#define CACHE_BUFFER_CAPACITY TEN_MB
+#define MAX_CACHE_ENTRIES ONE_MB
+#define MAX_FILENAME_LENGTH 4096
+#define MAX_THREADS 256
+/* Files are split into chunks of about this many bytes, which threads for '-j'
+   translate separately. */
+#define PARSE_CHUNK_LENGTH ONE_MB
+/* The lexer hands tokens to the parser in windows of this many tokens. */
+#define LEX_WINDOW_LENGTH 1024
+/* At most this many input files are being opened or read at once, and a
+   single read asks for at most this many bytes. */
+#define READING_QUEUE_LENGTH 64
+#define READING_MAX_READ (1024 * ONE_MB)
+/* Standard input is translated through a window of this many bytes, which
+   each declaration in it has to fit in, and is read this many bytes at a time
+   at least. */
+#define STREAM_WINDOW_LENGTH (16 * ONE_MB)
+#define STREAM_READ_LENGTH ONE_MB
+#define THREAD_STACK_SIZE (8 * ONE_MB)
+/* Arrays that are filled from the start are backed with huge pages past this
+   many bytes, so small inputs don't pay for them. */
+#define HUGE_PAGES_START (8 * ONE_MB)
 
 /* -------------------------------------------------------------------------------- */
 
@@ -58,6 +94,7 @@ typedef u8_t bool_t;
  * Since we do not use the C standard library, we must define our own syscall wrappers.
  * -------------------------------------------------------------------------------- */
 
+void* syscall6(void* number, void* arg1, void* arg2, void* arg3, void* arg4, void* arg5, void* arg6);
 void* syscall5(void* number, void* arg1, void* arg2, void* arg3, void* arg4, void* arg5);
 void* syscall4(void* number, void* arg1, void* arg2, void* arg3, void* arg4);
 void* syscall3(void* number, void* arg1, void* arg2, void* arg3);
@@ -77,11 +114,203 @@ i64_t syscall_open(char const* filename, u64_t flags, u64_t mode) {
 }
 
 #define O_RDONLY 00
+#define O_WRONLY 01
+#define O_CREAT 0100
+#define O_TRUNC 01000
+#define O_APPEND 02000
+
+i64_t syscall_close(i32_t fd) {
+  return (i64_t) syscall1((void*)3, (void*)(i64_t)fd);
+}
+
+i64_t syscall_rename(char const* old_filename, char const* new_filename) {
+  return (i64_t) syscall2((void*)82, (void*)old_filename, (void*)new_filename);
+}
+
+i64_t syscall_lseek(i32_t fd, i64_t offset, u32_t whence) {
+  return (i64_t) syscall3((void*)8, (void*)(i64_t)fd, (void*)offset, (void*)(u64_t)whence);
+}
+
+#define SEEK_END 2
+
+void* syscall_mmap(void* address, u64_t length, u64_t protection, u64_t flags, i32_t fd, u64_t offset) {
+  return syscall6((void*)9, address, (void*)length, (void*)protection, (void*)flags, (void*)(i64_t)fd, (void*)offset);
+}
+
+i64_t syscall_munmap(void* address, u64_t length) {
+  return (i64_t) syscall2((void*)11, address, (void*)length);
+}
+
+void* syscall_mremap(void* address, u64_t old_length, u64_t new_length, u64_t flags) {
+  return syscall4((void*)25, address, (void*)old_length, (void*)new_length, (void*)flags);
+}
+
+#define PROT_READ 0x1
+#define PROT_WRITE 0x2
+#define MAP_PRIVATE 0x02
+#define MAP_ANONYMOUS 0x20
+#define MAP_NORESERVE 0x4000
+#define MREMAP_MAYMOVE 1
+
+i64_t syscall_madvise(void* address, u64_t length, i32_t advice) {
+  return (i64_t) syscall3((void*)28, address, (void*)length, (void*)(i64_t)advice);
+}
+
+#define MADV_HUGEPAGE 14
+#define HUGE_PAGE_LENGTH (2 * ONE_MB)
+
+/* Syscalls that return pointers report errors as small negative numbers,
+   which land in the last page of the address space. */
+bool_t syscall_mmap_failed(void* result) {
+  return (u64_t) result > (u64_t) -4096;
+}
+
+i64_t syscall_arch_prctl(i32_t code, u64_t address) {
+  return (i64_t) syscall2((void*)158, (void*)(i64_t)code, (void*)address);
+}
+
+#define ARCH_SET_FS 0x1002
+
+i64_t syscall_futex(u32_t* address, i32_t operation, u32_t value) {
+  return (i64_t) syscall4((void*)202, address, (void*)(i64_t)operation, (void*)(u64_t)value, (void*)0);
+}
+
+#define FUTEX_WAIT_PRIVATE 128
+#define FUTEX_WAKE_PRIVATE 129
+
+typedef struct timespec_t {
+  i64_t seconds;
+  i64_t nanoseconds;
+} timespec_t;
+
+i64_t syscall_clock_gettime(i32_t clock, timespec_t* time) {
+  return (i64_t) syscall2((void*)228, (void*)(i64_t)clock, time);
+}
+
+#define CLOCK_MONOTONIC 1
+
+/* The first version of the attributes of a performance counter, which is all
+   that counting needs. The flags are a bitfield in the kernel's header. */
+typedef struct perf_event_attr_t {
+  u32_t type;
+  u32_t size;
+  u64_t config;
+  u64_t sample_period;
+  u64_t sample_type;
+  u64_t read_format;
+  u64_t flags;
+  u32_t wakeup_events;
+  u32_t bp_type;
+  u64_t config1;
+} perf_event_attr_t;
 
+i64_t syscall_perf_event_open(perf_event_attr_t* attributes, i32_t pid, i32_t cpu, i32_t group_fd, u64_t flags) {
+  return (i64_t) syscall5((void*)298, attributes, (void*)(i64_t)pid, (void*)(i64_t)cpu, (void*)(i64_t)group_fd, (void*)flags);
+}
+
+#define PERF_TYPE_HARDWARE 0
+#define PERF_TYPE_SOFTWARE 1
+#define PERF_COUNT_HW_CPU_CYCLES 0
+#define PERF_COUNT_HW_INSTRUCTIONS 1
+#define PERF_COUNT_HW_CACHE_MISSES 3
+#define PERF_COUNT_HW_BRANCH_MISSES 5
+#define PERF_COUNT_SW_PAGE_FAULTS 2
+#define PERF_FORMAT_GROUP 8
+#define PERF_ATTR_EXCLUDE_KERNEL (1 << 5)
+#define PERF_ATTR_EXCLUDE_HV (1 << 6)
+#define PERF_FLAG_FD_CLOEXEC 8
+
+/* The parts of the io_uring interface that reading the input files uses. The
+   submission and completion queues are rings shared with the kernel, whose
+   layout the kernel reports through the parameters of the setup call. */
+typedef struct io_uring_sq_offsets_t {
+  u32_t head;
+  u32_t tail;
+  u32_t ring_mask;
+  u32_t ring_entries;
+  u32_t flags;
+  u32_t dropped;
+  u32_t array;
+  u32_t reserved;
+  u64_t user_address;
+} io_uring_sq_offsets_t;
+
+typedef struct io_uring_cq_offsets_t {
+  u32_t head;
+  u32_t tail;
+  u32_t ring_mask;
+  u32_t ring_entries;
+  u32_t overflow;
+  u32_t cqes;
+  u32_t flags;
+  u32_t reserved;
+  u64_t user_address;
+} io_uring_cq_offsets_t;
+
+typedef struct io_uring_params_t {
+  u32_t sq_entries;
+  u32_t cq_entries;
+  u32_t flags;
+  u32_t sq_thread_cpu;
+  u32_t sq_thread_idle;
+  u32_t features;
+  u32_t wq_fd;
+  u32_t reserved[3];
+  io_uring_sq_offsets_t sq_offsets;
+  io_uring_cq_offsets_t cq_offsets;
+} io_uring_params_t;
+
+typedef struct io_uring_sqe_t {
+  u8_t opcode;
+  u8_t flags;
+  u16_t priority;
+  i32_t fd;
+  u64_t offset;
+  u64_t address;
+  u32_t length;
+  u32_t operation_flags;
+  u64_t user_data;
+  u64_t padding[3];
+} io_uring_sqe_t;
+
+typedef struct io_uring_cqe_t {
+  u64_t user_data;
+  i32_t result;
+  u32_t flags;
+} io_uring_cqe_t;
+
+i64_t syscall_io_uring_setup(u32_t entries, io_uring_params_t* params) {
+  return (i64_t) syscall2((void*)425, (void*)(u64_t)entries, params);
+}
+
+i64_t syscall_io_uring_enter(i32_t fd, u32_t to_submit, u32_t min_complete, u32_t flags) {
+  return (i64_t) syscall6((void*)426, (void*)(i64_t)fd, (void*)(u64_t)to_submit, (void*)(u64_t)min_complete, (void*)(u64_t)flags, (void*)0, (void*)0);
+}
+
+#define MAP_SHARED 0x01
+#define MAP_POPULATE 0x8000
+#define IORING_OFF_SQ_RING 0
+#define IORING_OFF_CQ_RING 0x8000000
+#define IORING_OFF_SQES 0x10000000
+#define IORING_ENTER_GETEVENTS 1
+#define IORING_FEAT_RW_CUR_POS 8
+#define IORING_OP_OPENAT 18
+#define IORING_OP_READ 22
+#define AT_FDCWD -100
+#define EINTR 4
+#define EINVAL 22
+#define EOPNOTSUPP 95
+
+/* Exits the whole process, including any threads other than the calling
+   one. */
 i64_t syscall_exit(i32_t status) {
-  return (i64_t) syscall1((void*)60, (void*)(i64_t)status);
+  return (i64_t) syscall1((void*)231, (void*)(i64_t)status);
 }
 
+/* Starts a thread with the given stack and thread pointer. Defined in
+   main.S. */
+i64_t thread_spawn(void* stack_top, void* thread_pointer, i32_t (*function)(void*), void* argument);
+
 /* -------------------------------------------------------------------------------- */
 
 /* --------------------------------------------------------------------------------
@@ -100,6 +329,30 @@ size_t min_size(size_t a, size_t b) {
   }
 }
 
+/* Counts of the work the calling thread did, which '-s' reports. They count
+   what could grow faster than the input does, so that tests can check that it
+   doesn't, without depending on how fast the machine is: probes into the
+   strings hashmap, bytes of strings compared, bytes copied into strings_data
+   or moved within the window of standard input, and steps over
+   expressions and local variables. */
+#define work_probes 0
+#define work_compared 1
+#define work_copied 2
+#define work_steps 3
+#define work_count 4
+
+__thread size_t work_counts[work_count];
+
+void copy_bytes(void* destination, void const* source, size_t length) {
+  u8_t* to = destination;
+  u8_t const* from = source;
+  size_t i = 0;
+  while (i < length) {
+    to[i] = from[i];
+    i = i + 1;
+  }
+}
+
 bool_t string_equal(char* expected, char* actual) {
   size_t i = 0;
   while (true) {
@@ -112,6 +365,97 @@ bool_t string_equal(char* expected, char* actual) {
   }
 }
 
+size_t string_length(char const* s) {
+  size_t length = 0;
+  while (s[length]) {
+    length = length + 1;
+  }
+  return length;
+}
+
+bool_t string_ends_with(char const* s, char const* suffix) {
+  size_t length = string_length(s);
+  size_t suffix_length = string_length(suffix);
+  if (suffix_length > length) {
+    return false;
+  }
+  size_t i = 0;
+  while (i < suffix_length) {
+    if (s[length - suffix_length + i] != suffix[i]) {
+      return false;
+    }
+    i = i + 1;
+  }
+  return true;
+}
+
+/* -------------------------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------------------
+ * THREADS
+ *
+ * With '-j', the files given to translate are translated by several threads at
+ * once. The state of the parser and the emitter is declared __thread, so that
+ * each thread has its own copy; the large arrays are allocated separately for
+ * each thread, so only the pointers to them are thread-local. The strings and
+ * the tables of declarations are shared.
+ *
+ * The declarations of all the files are prescanned before any thread starts,
+ * so the tables of declarations are only read while the threads run. The
+ * prescan also splits the files into chunks at declarations, so that a large
+ * file is translated by several threads too. Threads take the chunks in
+ * order, and the output of each chunk is kept in memory until it can be
+ * written out in order. Errors wait until all the earlier chunks are done, so
+ * the error that gets reported is the one a serial run would report.
+ * -------------------------------------------------------------------------------- */
+
+bool_t threads_enabled = false;
+
+/* The index of the chunk the current thread is translating plus one, or 0 if
+   it is not translating a chunk for '-j'. */
+__thread u32_t threads_chunk = 0;
+
+u32_t threads_chunk_count = 0;
+/* The number of chunks, counting from the first, that are completely
+   translated. Threads that wait for earlier chunks sleep on it with a futex. */
+u32_t threads_done_prefix = 0;
+/* Whether each chunk is completely translated. */
+u8_t* threads_done = 0;
+
+/* Reserves count consecutive elements at the end of an array that the threads
+   share, and returns the index of the first one. */
+size_t threads_reserve(size_t* length, size_t count) {
+  if (threads_enabled) {
+    return __atomic_fetch_add(length, count, __ATOMIC_RELAXED);
+  }
+  size_t first = *length;
+  *length = first + count;
+  return first;
+}
+
+void threads_wait_for_earlier_chunks() {
+  while (true) {
+    u32_t prefix = __atomic_load_n(&threads_done_prefix, __ATOMIC_ACQUIRE);
+    if (prefix + 1 >= threads_chunk) {
+      return;
+    }
+    syscall_futex(&threads_done_prefix, FUTEX_WAIT_PRIVATE, prefix);
+  }
+}
+
+/* Marks a chunk as done, and moves the prefix past it and any later chunks
+   that finished first. */
+void threads_finish_chunk(u32_t index) {
+  __atomic_store_n(&threads_done[index], 1, __ATOMIC_SEQ_CST);
+  while (true) {
+    u32_t prefix = __atomic_load_n(&threads_done_prefix, __ATOMIC_SEQ_CST);
+    if (prefix == threads_chunk_count || !__atomic_load_n(&threads_done[prefix], __ATOMIC_SEQ_CST)) {
+      break;
+    }
+    __atomic_compare_exchange_n(&threads_done_prefix, &prefix, prefix + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  }
+  syscall_futex(&threads_done_prefix, FUTEX_WAKE_PRIVATE, 0x7fffffff);
+}
 
 /* -------------------------------------------------------------------------------- */
 
@@ -125,10 +469,10 @@ bool_t string_equal(char* expected, char* actual) {
  * -------------------------------------------------------------------------------- */
 
 const size_t LOG_BUFFER_LEN_MINUS_ONE = 1024;
-char log_buffer[1023];
-size_t log_index = 0;
-size_t log_indent_count = 0;
-bool_t log_at_start_of_line = true;
+__thread char log_buffer[1023];
+__thread size_t log_index = 0;
+__thread size_t log_indent_count = 0;
+__thread bool_t log_at_start_of_line = true;
 
 void log_maybe_add_indent() {
   size_t indent_count = min_size(log_indent_count, LOG_BUFFER_LEN_MINUS_ONE);
@@ -158,7 +502,7 @@ void log_string(char const* s) {
 
 /* Add a string of the specified length to the log. The string must not contain
    any null characters. */
-void log_lstring(char* s, size_t length) {
+void log_lstring(char const* s, size_t length) {
   size_t s_index = 0;
   log_maybe_add_indent();
   while (log_index < LOG_BUFFER_LEN_MINUS_ONE && s_index < length) {
@@ -177,6 +521,7 @@ size_t log_size(size_t x) {
   while (x / magnitude >= 10) {
     magnitude = magnitude * 10;
   }
+  log_maybe_add_indent();
   size_t original_log_index = log_index;
   while (magnitude > 0 && log_index < LOG_BUFFER_LEN_MINUS_ONE) {
     char c = (char) (x / magnitude) + '0';
@@ -189,6 +534,9 @@ size_t log_size(size_t x) {
 }
 
 void log_newline() {
+  if (threads_chunk) {
+    threads_wait_for_earlier_chunks();
+  }
   log_buffer[log_index] = '\n';
   log_index = log_index + 1;
   syscall_write(2, log_buffer, log_index);
@@ -204,7 +552,7 @@ void log_dedent() {
   log_indent_count = log_indent_count - 2;
 }
 
-void log_line(char* s) {
+void log_line(char const* s) {
   log_string(s);
   log_newline();
 }
@@ -220,1035 +568,5667 @@ void ensure_array_space(size_t current_length, size_t capacity, char* array_name
   }
 }
 
-/* --------------------------------------------------------------------------------
- * STRINGS
- *
- * Strings that need to be looked up get stored in a single hashmap that maps
- * the string to somewhat small index, effectively providing a way to hash cons
- * a string on demand. Code that would otherwise have needed a string hash map
- * can instead use an array indexed of string's key in the global string
- * hashmap.
- * -------------------------------------------------------------------------------- */
+/* Returns zeroed memory. Pages are only backed once they are touched, so large
+   arrays that are usually mostly empty are cheap. */
+void* memory_allocate(size_t length) {
+  void* memory = syscall_mmap(0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (syscall_mmap_failed(memory)) {
+    log_line("Got unix error code while allocating memory.");
+    syscall_exit(1);
+  }
+  return memory;
+}
 
-char strings_data[MAX_STRINGS_DATA] = {0};
-size_t strings_data_index = 0;
+/* Like memory_allocate, for large arrays that are filled from the start. Past
+   HUGE_PAGES_START bytes they use huge pages where the kernel allows it,
+   which saves TLB misses on big inputs. */
+void* memory_allocate_dense(size_t length) {
+  u8_t* memory = memory_allocate(length);
+  if (length > HUGE_PAGES_START + HUGE_PAGE_LENGTH) {
+    syscall_madvise(memory + HUGE_PAGES_START, length - HUGE_PAGES_START, MADV_HUGEPAGE);
+  }
+  return memory;
+}
 
-/* The index into this array must be representable by 16 bits. */
-char* strings_pointers[STRINGS_ID_MAP_LENGTH];
-size_t strings_pointers_count = 0;
+/* Some limits can be changed on the command line, with '-l name=count'. The
+   arrays that depend on them are allocated by limits_allocate_arrays once the
+   options are known. The maximums come from the widths of the indexes into
+   those arrays, and the strings limit has to leave room for the built-in
+   strings. */
+size_t limit_strings = MAX_STRINGS;
+size_t limit_strings_data = MAX_STRINGS_DATA;
+size_t limit_expressions = MAX_EXPRESSIONS;
+size_t limit_expression_nesting = MAX_EXPRESSION_NESTING;
+size_t limit_fn_arguments = MAX_FN_ARGUMENTS;
+size_t limit_cache_entries = MAX_CACHE_ENTRIES;
 
-typedef u16_t strings_id_t;
+typedef struct limit_t {
+  char* name;
+  size_t* value;
+  size_t minimum;
+  size_t maximum;
+} limit_t;
 
-const u32_t FNV_OFFSET_BASIS = 0x811c9dc5;
-const u32_t FNV_PRIME = 0x01000193;
+#define LIMIT_COUNT 6
+limit_t limits[LIMIT_COUNT] = {
+  { .name = "strings", .value = &limit_strings, .minimum = BUILTIN_STRINGS_COUNT, .maximum = (size_t) 1 << 31 },
+  { .name = "strings-data", .value = &limit_strings_data, .minimum = 1, .maximum = (size_t) 1 << 40 },
+  { .name = "expressions", .value = &limit_expressions, .minimum = 1, .maximum = (size_t) 1 << 31 },
+  { .name = "nesting", .value = &limit_expression_nesting, .minimum = 1, .maximum = (size_t) 1 << 31 },
+  { .name = "arguments", .value = &limit_fn_arguments, .minimum = 1, .maximum = (size_t) 1 << 31 },
+  { .name = "cache-entries", .value = &limit_cache_entries, .minimum = 1, .maximum = (size_t) 1 << 31 }
+};
 
-/* Checks if the given candidate string is equal to a target string. The
-   candidate string is null-terminated. The target string is not
-   null-terminated, but instead is bounded by the provided length. It must not
-   contain any null characters. */
-bool_t check_candidate(char* candidate, char* target, size_t length) {
-  size_t i = 0;
-  while (i < length) {
-    /* If we have reached the end of the candidate string, then candidate[i]
-       will be 0. Since the target string does not contain null characters, we
-       will return instead of indexing candidate out of bounds on the next
-       iteration. */
-    if (target[i] != candidate[i]) {
-      return false;
+/* Sets a limit from the argument of '-l'. */
+void limits_set(char const* option) {
+  u32_t i = 0;
+  while (i < LIMIT_COUNT) {
+    char const* name = limits[i].name;
+    size_t length = 0;
+    while (name[length] && option[length] == name[length]) {
+      length = length + 1;
     }
-    i = i + 1;
-  }
-  /* For the strings to be equal, we need the next character in the candidate
-     string to be the terminating null character. */
-  return !candidate[i];
-}
-
-/* Finds the canonical id for the given string. Each time this function is
-   called, it first checks in a hashmap to see if the string is already
-   present; if it is, it returns the key. Otherwise it inserts the given string
-   into the hashmap using an arbitrary key and returns that key. */
-strings_id_t strings_id(char* string, size_t length) {
-  ensure_array_space(strings_pointers_count, STRINGS_ID_MAP_LENGTH, "strings_pointers");
-  size_t i;
-  u32_t hash = FNV_OFFSET_BASIS;
-  u16_t final_hash;
-  u16_t candidate_index;
-  char* candidate;
-  i = 0;
-  while (i < length) {
-    hash = hash ^ (u32_t) string[i];
-    hash = hash * FNV_PRIME;
-    i = i + 1;
-  }
-  /* XOR the left 16-bits with the right 16-bits to yield a smaller hash
-     result than the 32-bits produced by the standard fnv-1a hash loop. This
-     final hash value becomes the initial candidate for the result id. */
-  final_hash = (u16_t) ((hash >> 16) ^ (hash && 0xffff));
-  candidate_index = final_hash;
-  /* Iterate through all possible u16 values. We use do-while loop because the
-     start condition is indistinguishable from the end condition - both
-     conditions are "candidate_index == final_hash"; after the first iteration,
-     the numbers will become different until we wrap around and come back to
-     the starting value. */
-  do {
-    candidate = strings_pointers[candidate_index];
-    if (candidate) {
-      if (check_candidate(candidate, string, length)) {
-        return candidate_index;
+    if (!name[length] && option[length] == '=') {
+      char const* digits = &option[length + 1];
+      size_t value = 0;
+      size_t j = 0;
+      while (digits[j] >= '0' && digits[j] <= '9' && value <= limits[i].maximum) {
+        value = value * 10 + digits[j] - '0';
+        j = j + 1;
       }
-    } else {
-      /* The candidate being the null pointer indicates that the slot is free,
-         which means we should fill it in with the input string. */
-      ensure_array_space(strings_data_index + length, MAX_STRINGS_DATA, "strings_data");
-      strings_pointers[candidate_index] = &strings_data[strings_data_index];
-      i = 0;
-      while (i < length) {
-        strings_data[strings_data_index] = string[i];
-        i = i + 1;
-        strings_data_index = strings_data_index + 1;
+      if (digits[j] || value < limits[i].minimum || value > limits[i].maximum) {
+        log_string("Expected a limit on ");
+        log_string(name);
+        log_string(" from ");
+        log_size(limits[i].minimum);
+        log_string(" to ");
+        log_size(limits[i].maximum);
+        log_line(".");
+        syscall_exit(1);
       }
-      strings_data[strings_data_index] = 0;
-      strings_data_index = strings_data_index + 1;
-      strings_pointers_count = strings_pointers_count + 1;
-      return candidate_index;
-    }
-    candidate_index = candidate_index + 1;
-  } while (candidate_index != final_hash);
-  log_line("impossible");
-  return 0;
+      *limits[i].value = value;
+      return;
+    }
+    i = i + 1;
+  }
+  log_line("Expected strings, strings-data, expressions, nesting, arguments or cache-entries, then '=' and a count, after '-l'.");
+  syscall_exit(1);
 }
 
-/* -------------------------------------------------------------------------------- */
-
 /* --------------------------------------------------------------------------------
- * BUILT-IN STRINGS
+ * MEASURING
  *
- * Some identifiers are special for the compiler. For example, all the
- * primitive types and keywords.
+ * With '-t', translate reports how much time went into each phase of the
+ * work. The time stamp counter is read whenever the phase changes, which is
+ * cheap enough to do around every string that is interned, and the counts are
+ * turned into time by comparing the whole run against the monotonic clock.
+ * Each thread keeps its own counts, so with '-j' the phases add up to more
+ * than the time the run took.
+ *
+ * With '-p', the hardware performance counters of each thread are read
+ * through perf_event_open instead, for each phase and for the translation of
+ * each kind of declaration. Reading them takes a system call, so interning is
+ * counted as part of lexing. Counters that the machine or the kernel doesn't
+ * offer are left out of the report.
  * -------------------------------------------------------------------------------- */
 
-strings_id_t builtin_strings_void;
-strings_id_t builtin_strings_if;
-strings_id_t builtin_strings_else;
-strings_id_t builtin_strings_while;
-strings_id_t builtin_strings_return;
-strings_id_t builtin_strings_end;
-strings_id_t builtin_strings_switch;
-strings_id_t builtin_strings_case;
-
-void builtin_strings_init() {
-  builtin_strings_void = strings_id("void", 4);
-  builtin_strings_if = strings_id("if", 2);
-  builtin_strings_else = strings_id("else", 4);
-  builtin_strings_while = strings_id("while", 5);
-  builtin_strings_return = strings_id("return", 6);
-  builtin_strings_end = strings_id("end", 3);
-  builtin_strings_switch = strings_id("switch", 6);
-  builtin_strings_case = strings_id("case", 4);
-}
+typedef u8_t measure_phase_t;
+#define measure_phase_read 0
+#define measure_phase_lex 1
+#define measure_phase_intern 2
+#define measure_phase_parse 3
+#define measure_phase_emit 4
+#define measure_phase_count 5
 
-/* -------------------------------------------------------------------------------- */
+char const* const measure_phase_names[measure_phase_count] = {
+  "read", "lex", "intern", "parse", "emit"
+};
 
-typedef struct location_t {
-  size_t line;
-  size_t column;
-  size_t start_of_line;
-  size_t index;
-} location_t;
+bool_t measure_timing = false;
+/* Everything that is not in another phase is counted as parsing. */
+__thread measure_phase_t measure_phase = measure_phase_parse;
+__thread u64_t measure_phase_start = 0;
+__thread u64_t measure_cycles[measure_phase_count];
+__thread u64_t measure_declarations = 0;
 
-char parse_read_buffer[PARSE_READ_BUFFER_CAPACITY];
-size_t parse_read_buffer_length = 0;
+/* The counts of the threads that are done, and of the main thread once it is
+   done. */
+u64_t measure_total_cycles[measure_phase_count];
+u64_t measure_total_declarations = 0;
+u64_t measure_input_bytes = 0;
+u64_t measure_start_nanoseconds = 0;
+u64_t measure_start_cycles = 0;
 
-location_t current_location = {
-  .index = 0,
-  .line = 1,
-  .column = 1,
-  .start_of_line = 0
+typedef struct measure_counter_t {
+  char const* name;
+  u32_t type;
+  u64_t config;
+} measure_counter_t;
+
+#define MEASURE_COUNTER_COUNT 5
+
+measure_counter_t const measure_counters[MEASURE_COUNTER_COUNT] = {
+  { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { "cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+  { "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  { "page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS }
 };
 
-char const* current_filename;
+/* The counters are reported for each phase, and then for each kind of
+   declaration. */
+#define MEASURE_DECLARATION_ROWS 3
+#define MEASURE_ROWS (measure_phase_count + MEASURE_DECLARATION_ROWS)
+#define MEASURE_NO_COUNTER 0xff
 
-void parse_log_location(location_t location) {
-  log_string(current_filename);
-  log_string(":");
-  log_size(location.line);
-  log_string(":");
-  log_size(location.column);
-  log_string(": ");
-}
+char const* const measure_declaration_names[MEASURE_DECLARATION_ROWS] = {
+  "struct", "const", "fn"
+};
 
-void parse_log_current_location() {
-  parse_log_location(current_location);
+bool_t measure_counting = false;
+/* Whether any thread could open each counter. */
+bool_t measure_counter_opened[MEASURE_COUNTER_COUNT];
+/* The counters of a thread are opened as one group, so that a single read
+   gets all of them, in the order they were opened. */
+__thread i32_t measure_counters_fd = -1;
+__thread u8_t measure_counter_positions[MEASURE_COUNTER_COUNT];
+/* The phase that counts are going to. It is the same as measure_phase, except
+   that interning is counted as lexing. */
+__thread measure_phase_t measure_counted_phase = measure_phase_parse;
+__thread u64_t measure_counter_values[MEASURE_COUNTER_COUNT];
+__thread u64_t measure_counts[MEASURE_ROWS][MEASURE_COUNTER_COUNT];
+u64_t measure_total_counts[MEASURE_ROWS][MEASURE_COUNTER_COUNT];
+
+u64_t measure_nanoseconds() {
+  timespec_t time;
+  syscall_clock_gettime(CLOCK_MONOTONIC, &time);
+  return (u64_t) time.seconds * 1000000000 + (u64_t) time.nanoseconds;
 }
 
-void parse_log_location_line_with_column_marker(location_t location) {
-  size_t line_number_length = log_size(location.line);
-  log_string(" | ");
-  size_t code_line_error_position = location.index - location.start_of_line;
-  size_t end_of_line = location.start_of_line;
-  size_t end_of_line_limit = location.start_of_line + MAX_LINE_LENGTH_FOR_ERRORS;
-  bool_t reached_end_of_line = false;
-  while (end_of_line < end_of_line_limit) {
-    if (end_of_line >= parse_read_buffer_length || parse_read_buffer[end_of_line] == '\n') {
-      reached_end_of_line = true;
-      break;
+void measure_open_counters() {
+  i32_t leader = -1;
+  u8_t position = 0;
+  size_t i = 0;
+  while (i < MEASURE_COUNTER_COUNT) {
+    perf_event_attr_t attributes = {
+      .type = measure_counters[i].type,
+      .size = sizeof(perf_event_attr_t),
+      .config = measure_counters[i].config,
+      .read_format = PERF_FORMAT_GROUP,
+      .flags = PERF_ATTR_EXCLUDE_KERNEL | PERF_ATTR_EXCLUDE_HV
+    };
+    i64_t fd = syscall_perf_event_open(&attributes, 0, -1, leader, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0) {
+      measure_counter_positions[i] = MEASURE_NO_COUNTER;
+    } else {
+      if (leader < 0) {
+        leader = fd;
+      }
+      measure_counter_positions[i] = position;
+      position = position + 1;
+      __atomic_store_n(&measure_counter_opened[i], true, __ATOMIC_RELAXED);
     }
-    end_of_line = end_of_line + 1;
-  }
-  size_t code_line_length = end_of_line - location.start_of_line;
-  log_lstring(&parse_read_buffer[location.start_of_line], code_line_length);
-  if (!reached_end_of_line) {
-    log_string("...");
+    i = i + 1;
   }
-  if (location.index >= parse_read_buffer_length) {
-    log_string("<end-of-file>");
+  measure_counters_fd = leader;
+}
+
+/* Reads the counters of the calling thread, leaving those it doesn't have at
+   zero. */
+void measure_read_counters(u64_t* values) {
+  /* A group is read as the number of counters in it followed by their
+     values. */
+  u64_t group[1 + MEASURE_COUNTER_COUNT] = {0};
+  if (measure_counters_fd >= 0) {
+    syscall_read(measure_counters_fd, group, sizeof(group));
   }
-  log_newline();
-  size_t error_position_minus_one = line_number_length + 3 + code_line_error_position - 1;
   size_t i = 0;
-  while (i < error_position_minus_one) {
-    log_string(" ");
+  while (i < MEASURE_COUNTER_COUNT) {
+    u8_t position = measure_counter_positions[i];
+    values[i] = position == MEASURE_NO_COUNTER ? 0 : group[1 + position];
     i = i + 1;
   }
-  log_string("^");
-  log_newline();
 }
 
-void parse_log_current_location_line_with_column_marker() {
-  parse_log_location_line_with_column_marker(current_location);
+/* Adds what the counters counted since they were last read to the given
+   row. */
+void measure_count(size_t row) {
+  u64_t values[MEASURE_COUNTER_COUNT];
+  measure_read_counters(values);
+  size_t i = 0;
+  while (i < MEASURE_COUNTER_COUNT) {
+    measure_counts[row][i] = measure_counts[row][i] + values[i] - measure_counter_values[i];
+    measure_counter_values[i] = values[i];
+    i = i + 1;
+  }
 }
 
-/* Returns the next character in the stream. If the current buffer of
-   characters has been exhausted, we perform a blocking read on stdin to refill
-   it. If the read fail, we abort. A return value of 0 indicates that there are
-   no more characters to get. */
-char peek_char() {
-  if (current_location.index < parse_read_buffer_length) {
-    return parse_read_buffer[current_location.index];
-  } else {
-    return 0;
+/* Switches the calling thread to the given phase, and returns the phase it
+   was in, to switch back to. */
+measure_phase_t measure_switch(measure_phase_t phase) {
+  measure_phase_t previous = measure_phase;
+  if (measure_timing) {
+    u64_t now = __builtin_ia32_rdtsc();
+    measure_cycles[previous] = measure_cycles[previous] + now - measure_phase_start;
+    measure_phase_start = now;
   }
+  if (measure_counting) {
+    measure_phase_t counted = phase == measure_phase_intern ? measure_phase_lex : phase;
+    if (counted != measure_counted_phase) {
+      measure_count(measure_counted_phase);
+      measure_counted_phase = counted;
+    }
+  }
+  measure_phase = phase;
+  return previous;
 }
 
-void advance_location(location_t* location) {
-  char c = parse_read_buffer[location->index];
-  bool_t is_newline = c == '\n';
-  location->column = location->column * !is_newline + 1;
-  location->line = location->line + is_newline * 1;
-  location->index = location->index + 1;
-  location->start_of_line = location->start_of_line * !is_newline + location->index * is_newline;
+/* The counters are read before and after each declaration, as well as when
+   the phase changes, so the rows of the declarations overlap those of the
+   phases. */
+void measure_start_declaration(u64_t* values) {
+  if (measure_counting) {
+    measure_read_counters(values);
+  }
 }
 
-/* Skip past the current character. The behavior is undefined if the stream is
-   already exhausted, so it is necessary to have first gotten a non-zero return
-   value from peek_char. */
-void advance_char() {
-  char c = parse_read_buffer[current_location.index];
-  bool_t is_newline = c == '\n';
-  current_location.column = current_location.column * !is_newline + 1;
-  current_location.line = current_location.line + is_newline * 1;
-  current_location.index = current_location.index + 1;
-  current_location.start_of_line = current_location.start_of_line * !is_newline + current_location.index * is_newline;
+/* The kinds of declarations are numbered like declaration_kind_t, which is
+   defined with the parser. */
+void measure_finish_declaration(u64_t const* start_values, u8_t kind) {
+  if (!measure_counting) {
+    return;
+  }
+  size_t row = measure_phase_count + kind;
+  u64_t values[MEASURE_COUNTER_COUNT];
+  measure_read_counters(values);
+  size_t i = 0;
+  while (i < MEASURE_COUNTER_COUNT) {
+    measure_counts[row][i] = measure_counts[row][i] + values[i] - start_values[i];
+    i = i + 1;
+  }
 }
 
-/* Peek the next character and advance past it if non-zero. We do not abort if
-   the stream is ended because there is not enough context in this function to
-   give a good error message. The current position is advanced even if the
-   stream has ended because the convention is that the parsing index should sit
-   immediately after the index that gave it trouble; in other words, we parse
-   first, ask questions later. */
-char parse_char() {
-  char c = peek_char();
-  advance_char();
-  return c;
+void measure_start_thread() {
+  measure_phase_start = __builtin_ia32_rdtsc();
+  if (measure_counting) {
+    measure_open_counters();
+    measure_read_counters(measure_counter_values);
+  }
 }
 
-/* Tries to skip past the specified string. If the next characters do not match
-   the string or the stream ends before we find the whole string, we stop
-   advancing and return false. We do not abort on failure because there is not
-   enough context in this function to give a good error message. */
-bool_t parse_exactly(char* string) {
+void measure_finish_thread() {
+  measure_switch(measure_phase);
   size_t i = 0;
-  char parsed_char;
-  while (true) {
-    char string_char = string[i];
-    if (!string_char) {
-      return true;
+  while (i < measure_phase_count) {
+    __atomic_fetch_add(&measure_total_cycles[i], measure_cycles[i], __ATOMIC_RELAXED);
+    i = i + 1;
+  }
+  __atomic_fetch_add(&measure_total_declarations, measure_declarations, __ATOMIC_RELAXED);
+  if (measure_counting) {
+    measure_count(measure_counted_phase);
+    size_t row = 0;
+    while (row < MEASURE_ROWS) {
+      i = 0;
+      while (i < MEASURE_COUNTER_COUNT) {
+        __atomic_fetch_add(&measure_total_counts[row][i], measure_counts[row][i], __ATOMIC_RELAXED);
+        i = i + 1;
+      }
+      row = row + 1;
     }
-    parsed_char = parse_char();
-    if (parsed_char != string_char) {
-      return false;
-    } else if (!parsed_char) {
-      return true;
+    if (measure_counters_fd >= 0) {
+      syscall_close(measure_counters_fd);
     }
-    i = i + 1;
   }
 }
 
-/* Determines whether the given character is a whitespace character. */
-bool_t parse_is_whitespace(char c) {
-  switch (c) {
-    case ' ':
-    case '\t':
-    case '\n': return true;
-    default: return false;
-  }
+void measure_start(bool_t timing, bool_t counting) {
+  measure_timing = timing;
+  measure_counting = counting;
+  measure_start_nanoseconds = measure_nanoseconds();
+  measure_start_cycles = __builtin_ia32_rdtsc();
+  measure_start_thread();
 }
 
-/* Skips past whitespace, if there is any. */
-void parse_skip_whitespace() {
-  while (parse_is_whitespace(peek_char())) {
-    advance_char();
+/* Prints value / scale with as many decimals as scale has zeros. */
+void measure_log_fixed(u64_t value, u64_t scale) {
+  log_size(value / scale);
+  if (scale > 1) {
+    log_string(".");
+    u64_t digit_scale = scale / 10;
+    while (digit_scale > 0) {
+      log_size(value / digit_scale % 10);
+      digit_scale = digit_scale / 10;
+    }
   }
 }
 
-/* Skips past whitespace, but aborting if there is no whitespace to be found. */
-void parse_skip_whitespace1() {
-  if (parse_is_whitespace(parse_char())) {
-    parse_skip_whitespace();
-  } else {
-    parse_log_current_location();
-    log_line("Expected whitespace.");
-    parse_log_current_location_line_with_column_marker();
-    syscall_exit(1);
-  }
+void measure_log_row(char const* name, u64_t microseconds) {
+  u64_t divisor = microseconds ? microseconds : 1;
+  log_string(name);
+  log_string("\t");
+  measure_log_fixed(microseconds, 1000000);
+  log_string("\t");
+  /* A byte per microsecond is a megabyte per second. */
+  measure_log_fixed(measure_input_bytes * 10 / divisor, 10);
+  log_string("\t");
+  log_size(measure_total_declarations * 1000000 / divisor);
+  log_newline();
 }
 
-void parse_error_expected_declaration_start_keyword() {
+/* Prints a tab-separated table with a row for each phase and one for the
+   whole run, giving the seconds spent, and the input bytes and declarations
+   handled per second. */
+void measure_report_timing() {
+  u64_t microseconds = (measure_nanoseconds() - measure_start_nanoseconds) / 1000;
+  u64_t cycles_per_microsecond = (__builtin_ia32_rdtsc() - measure_start_cycles) / (microseconds ? microseconds : 1);
+  if (cycles_per_microsecond == 0) {
+    cycles_per_microsecond = 1;
+  }
+  log_line("phase\tseconds\tMB/s\tdeclarations/s");
+  size_t i = 0;
+  while (i < measure_phase_count) {
+    measure_log_row(measure_phase_names[i], measure_total_cycles[i] / cycles_per_microsecond);
+    i = i + 1;
+  }
+  measure_log_row("total", microseconds);
+}
+
+#define MEASURE_COLUMN_WIDTH 16
+
+void measure_log_spaces(size_t count) {
+  size_t i = 0;
+  while (i < count) {
+    log_string(" ");
+    i = i + 1;
+  }
+}
+
+size_t measure_digits(u64_t x) {
+  size_t digits = 1;
+  while (x >= 10) {
+    x = x / 10;
+    digits = digits + 1;
+  }
+  return digits;
+}
+
+/* Prints a row of the counters table, with the name on the left and the
+   counts right-aligned in their columns. */
+void measure_log_counts_row(char const* name, u64_t const* counts) {
+  log_string(name);
+  measure_log_spaces(MEASURE_COLUMN_WIDTH - string_length(name));
+  size_t i = 0;
+  while (i < MEASURE_COUNTER_COUNT) {
+    if (measure_counter_opened[i]) {
+      measure_log_spaces(MEASURE_COLUMN_WIDTH - measure_digits(counts[i]));
+      log_size(counts[i]);
+    }
+    i = i + 1;
+  }
+  log_newline();
+}
+
+/* Prints a table of the counters for each phase, and one for each kind of
+   declaration. Interning is part of lexing here. */
+void measure_report_counters() {
+  bool_t any_opened = false;
+  size_t i = 0;
+  while (i < MEASURE_COUNTER_COUNT) {
+    any_opened = any_opened || measure_counter_opened[i];
+    i = i + 1;
+  }
+  if (!any_opened) {
+    log_line("No performance counters could be opened.");
+    return;
+  }
+  char const* headings[2] = { "phase", "declaration" };
+  size_t table = 0;
+  while (table < 2) {
+    if (table == 1) {
+      log_newline();
+    }
+    log_string(headings[table]);
+    measure_log_spaces(MEASURE_COLUMN_WIDTH - string_length(headings[table]));
+    i = 0;
+    while (i < MEASURE_COUNTER_COUNT) {
+      if (measure_counter_opened[i]) {
+        measure_log_spaces(MEASURE_COLUMN_WIDTH - string_length(measure_counters[i].name));
+        log_string(measure_counters[i].name);
+      }
+      i = i + 1;
+    }
+    log_newline();
+    size_t row = table == 0 ? 0 : measure_phase_count;
+    size_t end = table == 0 ? measure_phase_count : MEASURE_ROWS;
+    while (row < end) {
+      if (row != measure_phase_intern) {
+        char const* name = row < measure_phase_count ? measure_phase_names[row] : measure_declaration_names[row - measure_phase_count];
+        measure_log_counts_row(name, measure_total_counts[row]);
+      }
+      row = row + 1;
+    }
+    table = table + 1;
+  }
+}
+
+void measure_report() {
+  measure_finish_thread();
+  if (measure_timing) {
+    measure_report_timing();
+  }
+  if (measure_counting) {
+    measure_report_counters();
+  }
+}
+
+/* --------------------------------------------------------------------------------
+ * BUILT-IN STRINGS
+ *
+ * Some identifiers are special for the compiler. For example, all the
+ * primitive types and keywords. They always have the first ids, in the order
+ * of builtin_strings_words, and are recognized by a perfect hash before the
+ * strings hashmap is consulted, so that they never have to be interned.
+ * -------------------------------------------------------------------------------- */
+
+#define builtin_strings_void 0
+#define builtin_strings_if 1
+#define builtin_strings_else 2
+#define builtin_strings_while 3
+#define builtin_strings_return 4
+#define builtin_strings_end 5
+#define builtin_strings_switch 6
+#define builtin_strings_case 7
+#define builtin_strings_u64 8
+#define builtin_strings_i64 9
+#define builtin_strings_struct 10
+#define builtin_strings_const 11
+#define builtin_strings_fn 12
+#define builtin_strings_logical_or 13
+#define builtin_strings_logical_and 14
+#define builtin_strings_bit_or 15
+#define builtin_strings_bit_xor 16
+#define builtin_strings_bit_and 17
+#define builtin_strings_equal 18
+#define builtin_strings_not_equal 19
+#define builtin_strings_less 20
+#define builtin_strings_less_equal 21
+#define builtin_strings_greater 22
+#define builtin_strings_greater_equal 23
+#define builtin_strings_shift_left 24
+#define builtin_strings_shift_right 25
+#define builtin_strings_plus 26
+#define builtin_strings_minus 27
+#define builtin_strings_times 28
+#define builtin_strings_divide 29
+#define builtin_strings_remainder 30
+#define builtin_strings_size 31
+#define builtin_strings_i8 32
+#define builtin_strings_u8 33
+#define builtin_strings_i16 34
+#define builtin_strings_u16 35
+#define builtin_strings_i32 36
+#define builtin_strings_u32 37
+#define builtin_strings_f32 38
+#define builtin_strings_f64 39
+
+char* const builtin_strings_words[BUILTIN_STRINGS_COUNT] = {
+  "void", "if", "else", "while", "return", "end", "switch", "case",
+  "u64", "i64", "struct", "const", "fn", "||", "&&", "|",
+  "^", "&", "==", "!=", "<", "<=", ">", ">=",
+  "<<", ">>", "+", "-", "*", "/", "%", "size",
+  "i8", "u8", "i16", "u16", "i32", "u32", "f32", "f64"
+};
+
+u8_t const builtin_strings_lengths[BUILTIN_STRINGS_COUNT] = {
+  4, 2, 4, 5, 6, 3, 6, 4, 3, 3, 6, 5, 2, 2, 2, 1, 1, 1, 2, 2,
+  1, 2, 1, 2, 2, 2, 1, 1, 1, 1, 1, 4, 2, 2, 3, 3, 3, 3, 3, 3
+};
+
+/* The precedence of each built-in operator, indexed by the id of its string.
+   Higher numbers bind tighter, and the levels follow C. Any other operator has
+   precedence 0, so it binds looser than all of the built-in ones. */
+u8_t const builtin_strings_precedences[BUILTIN_STRINGS_COUNT] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 6,
+  7, 7, 7, 7, 8, 8, 9, 9, 10, 10, 10, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* Bits 4 to 11 of the FNV-1a hash of the built-in strings are all different,
+   so they pick a slot that holds the id plus one of the only built-in string
+   that can have that hash, or zero if there is none. */
+u8_t const builtin_strings_slots[256] = {
+  [0] = 20, [13] = 35, [27] = 22, [29] = 12, [33] = 24, [34] = 23, [37] = 1, [38] = 10,
+  [47] = 34, [52] = 25, [67] = 28, [74] = 37, [75] = 38, [90] = 6, [108] = 26, [113] = 9,
+  [117] = 30, [122] = 31, [123] = 5, [139] = 8, [140] = 4, [149] = 32, [157] = 13, [163] = 16,
+  [174] = 40, [176] = 17, [177] = 36, [187] = 33, [190] = 15, [191] = 3, [197] = 18, [204] = 19,
+  [218] = 27, [220] = 14, [224] = 2, [226] = 11, [236] = 39, [239] = 21, [243] = 29, [247] = 7
+};
+
+/* Returns the id of the built-in string with the given bytes and hash, or
+   BUILTIN_STRINGS_COUNT if it is not one of them. */
+size_t builtin_strings_find(char const* string, size_t length, u32_t hash) {
+  size_t id = (size_t) builtin_strings_slots[(hash >> 4) & 255] - 1;
+  if (id >= BUILTIN_STRINGS_COUNT || builtin_strings_lengths[id] != length) {
+    return BUILTIN_STRINGS_COUNT;
+  }
+  char const* word = builtin_strings_words[id];
+  size_t i = 0;
+  while (i < length) {
+    if (word[i] != string[i]) {
+      return BUILTIN_STRINGS_COUNT;
+    }
+    i = i + 1;
+  }
+  return id;
+}
+
+/* -------------------------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------------------
+ * STRINGS
+ *
+ * Strings that need to be looked up get stored in a single hashmap that maps
+ * the string to somewhat small index, effectively providing a way to hash cons
+ * a string on demand. Code that would otherwise have needed a string hash map
+ * can instead use an array indexed of string's key in the global string
+ * hashmap.
+ * -------------------------------------------------------------------------------- */
+
+char* strings_data = 0;
+size_t strings_data_index = 0;
+
+/* Ids are handed out densely in the order strings are first seen, so arrays
+   indexed by id only need to be as long as the number of distinct strings.
+   With '-j', two threads that add the same string at the same time both take
+   an id, and the id of the one that loses is never used. */
+typedef u32_t strings_id_t;
+
+char** strings_pointers = 0;
+u32_t* strings_lengths = 0;
+size_t strings_pointers_count = 0;
+
+/* Each slot is either zero, meaning it is free, or holds the full 32-bit hash
+   of a string in the upper half and its id plus one in the lower half. Keeping
+   the hash in the slot means that nearly all mismatches are rejected without
+   touching the string data at all.
+
+   A string is copied and given an id before its slot is filled in, and slots
+   never change once they are filled in, so threads can look strings up
+   without any locking. Threads that add strings at the same time race to fill
+   in the free slot with a compare-and-swap, and the loser carries on probing
+   from that slot.
+
+   The hashmap is kept at most half full so that probe sequences stay short,
+   and its number of slots is a power of two. */
+u64_t* strings_slots = 0;
+size_t strings_slots_mask = 0;
+
+/* Each thread copies strings into its own region of strings_data, so that
+   it only has to reserve space from the shared index once per region. */
+__thread char* strings_region = 0;
+__thread size_t strings_region_length = 0;
+
+const u32_t FNV_OFFSET_BASIS = 0x811c9dc5;
+const u32_t FNV_PRIME = 0x01000193;
+
+/* Checks whether two strings of the given length have the same bytes. */
+bool_t strings_equal_bytes(char const* a, char const* b, size_t length) {
+  work_counts[work_compared] = work_counts[work_compared] + length;
+  size_t i = 0;
+  while (i < length) {
+    if (a[i] != b[i]) {
+      return false;
+    }
+    i = i + 1;
+  }
+  return true;
+}
+
+/* Copies a string into strings_data and gives it the next id, without adding
+   it to the hashmap. */
+strings_id_t strings_add(char const* string, size_t length) {
+  char* copy;
+  if (length + 1 > strings_region_length) {
+    /* Long strings get exactly the space they need, so that they neither
+       waste the rest of the current region nor need one of their own. */
+    size_t reserved = length + 1 > STRINGS_REGION_LENGTH / 4 ? length + 1 : STRINGS_REGION_LENGTH;
+    size_t first = threads_reserve(&strings_data_index, reserved);
+    ensure_array_space(first + reserved - 1, limit_strings_data, "strings_data");
+    copy = &strings_data[first];
+    if (reserved == STRINGS_REGION_LENGTH) {
+      strings_region = copy + length + 1;
+      strings_region_length = reserved - length - 1;
+    }
+  } else {
+    copy = strings_region;
+    strings_region = strings_region + length + 1;
+    strings_region_length = strings_region_length - length - 1;
+  }
+  copy_bytes(copy, string, length);
+  copy[length] = 0;
+  work_counts[work_copied] = work_counts[work_copied] + length;
+  strings_id_t id = threads_reserve(&strings_pointers_count, 1);
+  ensure_array_space(id, limit_strings, "strings_pointers");
+  strings_pointers[id] = copy;
+  strings_lengths[id] = length;
+  return id;
+}
+
+strings_id_t strings_find_or_add(char const* string, size_t length, u32_t hash) {
+  size_t slot_index = hash & strings_slots_mask;
+  u64_t added = 0;
+  size_t probes = 0;
+  while (true) {
+    probes = probes + 1;
+    u64_t slot = __atomic_load_n(&strings_slots[slot_index], __ATOMIC_ACQUIRE);
+    if (!slot) {
+      /* We reached a free slot, so the string is not present yet. The load
+         factor guarantees that a free slot always exists. */
+      if (!added) {
+        added = ((u64_t) hash << 32) | (strings_add(string, length) + 1);
+      }
+      if (!threads_enabled) {
+        strings_slots[slot_index] = added;
+        work_counts[work_probes] = work_counts[work_probes] + probes;
+        return (strings_id_t) added - 1;
+      }
+      if (__atomic_compare_exchange_n(&strings_slots[slot_index], &slot, added, false, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+        work_counts[work_probes] = work_counts[work_probes] + probes;
+        return (strings_id_t) added - 1;
+      }
+      /* Another thread filled in the slot first, and slot now holds what it
+         wrote. That may well be the same string. */
+    }
+    if ((u32_t) (slot >> 32) == hash) {
+      strings_id_t candidate = (strings_id_t) slot - 1;
+      if (strings_lengths[candidate] == length && strings_equal_bytes(strings_pointers[candidate], string, length)) {
+        work_counts[work_probes] = work_counts[work_probes] + probes;
+        return candidate;
+      }
+    }
+    slot_index = (slot_index + 1) & strings_slots_mask;
+  }
+}
+
+/* Does the work of strings_id for a string whose hash is already known,
+   which is the case for the strings that the lexer hashes as it finds where
+   they end. */
+strings_id_t strings_id_hashed(char const* string, size_t length, u32_t hash) {
+  size_t builtin = builtin_strings_find(string, length, hash);
+  if (builtin < BUILTIN_STRINGS_COUNT) {
+    return (strings_id_t) builtin;
+  }
+  if (!measure_timing) {
+    return strings_find_or_add(string, length, hash);
+  }
+  measure_phase_t previous = measure_switch(measure_phase_intern);
+  strings_id_t id = strings_find_or_add(string, length, hash);
+  measure_switch(previous);
+  return id;
+}
+
+u32_t strings_hash_step(u32_t hash, char c) {
+  return (hash ^ (u8_t) c) * FNV_PRIME;
+}
+
+/* Finds the canonical id for the given string. Each time this function is
+   called, it first checks in a hashmap to see if the string is already
+   present; if it is, it returns the id. Otherwise it copies the string into
+   strings_data, assigns it the next id and returns that. */
+strings_id_t strings_id(char const* string, size_t length) {
+  size_t i = 0;
+  u32_t hash = FNV_OFFSET_BASIS;
+  while (i < length) {
+    hash = strings_hash_step(hash, string[i]);
+    i = i + 1;
+  }
+  return strings_id_hashed(string, length, hash);
+}
+
+/* -------------------------------------------------------------------------------- */
+
+/* Locations only track the byte offset into the file. Line and column
+   numbers are needed only for diagnostics, so they are computed from the offset
+   when a diagnostic is printed instead of being maintained for every
+   character. */
+typedef struct location_t {
+  size_t index;
+} location_t;
+
+/* The contents of the file currently being parsed. The file is mapped
+   directly into memory rather than copied, so there is no limit on its size
+   other than the address space. */
+__thread char const* parse_read_buffer = 0;
+__thread size_t parse_read_buffer_length = 0;
+
+__thread location_t current_location = { .index = 0 };
+
+__thread char const* current_filename;
+
+/* When standard input is translated, the buffer only holds a window of it,
+   which starts this many lines into the input and this many characters into
+   the line it starts in. */
+size_t parse_stream_lines = 0;
+size_t parse_stream_columns = 0;
+
+size_t scan_count_newlines(char const* data, size_t index, size_t end, size_t* last_newline);
+
+/* Finds the line number of a location and the index at which that line
+   starts. The location may be past the end of the file, since the parser
+   advances past the character that gave it trouble. */
+size_t parse_location_line(location_t location, size_t* start_of_line) {
+  size_t end = min_size(location.index, parse_read_buffer_length);
+  size_t last_newline = 0;
+  size_t newlines = scan_count_newlines(parse_read_buffer, 0, end, &last_newline);
+  *start_of_line = newlines ? last_newline + 1 : 0;
+  return parse_stream_lines + newlines + 1;
+}
+
+void parse_log_location(location_t location) {
+  size_t start_of_line;
+  size_t line = parse_location_line(location, &start_of_line);
+  log_string(current_filename);
+  log_string(":");
+  log_size(line);
+  log_string(":");
+  log_size(location.index - start_of_line + 1 + (start_of_line ? 0 : parse_stream_columns));
+  log_string(": ");
+}
+
+void parse_log_current_location() {
+  parse_log_location(current_location);
+}
+
+void parse_log_location_line_with_column_marker(location_t location) {
+  size_t start_of_line;
+  size_t line = parse_location_line(location, &start_of_line);
+  size_t line_number_length = log_size(line);
+  log_string(" | ");
+  size_t code_line_error_position = location.index - start_of_line;
+  size_t end_of_line = start_of_line;
+  size_t end_of_line_limit = start_of_line + MAX_LINE_LENGTH_FOR_ERRORS;
+  bool_t reached_end_of_line = false;
+  while (end_of_line < end_of_line_limit) {
+    if (end_of_line >= parse_read_buffer_length || parse_read_buffer[end_of_line] == '\n') {
+      reached_end_of_line = true;
+      break;
+    }
+    end_of_line = end_of_line + 1;
+  }
+  size_t code_line_length = end_of_line - start_of_line;
+  log_lstring(&parse_read_buffer[start_of_line], code_line_length);
+  if (!reached_end_of_line) {
+    log_string("...");
+  }
+  if (location.index >= parse_read_buffer_length) {
+    log_string("<end-of-file>");
+  }
+  log_newline();
+  size_t error_position_minus_one = line_number_length + 3 + code_line_error_position - 1;
+  size_t i = 0;
+  while (i < error_position_minus_one) {
+    log_string(" ");
+    i = i + 1;
+  }
+  log_string("^");
+  log_newline();
+}
+
+void parse_log_current_location_line_with_column_marker() {
+  parse_log_location_line_with_column_marker(current_location);
+}
+
+/* Returns the next character in the stream. A return value of 0 indicates
+   that there are no more characters to get. */
+char peek_char() {
+  if (current_location.index < parse_read_buffer_length) {
+    return parse_read_buffer[current_location.index];
+  } else {
+    return 0;
+  }
+}
+
+/* Skip past the current character. Advancing past the end of the stream is
+   allowed, so that diagnostics can point just after the end of the file. */
+void advance_char() {
+  current_location.index = current_location.index + 1;
+}
+
+/* Peek the next character and advance past it if non-zero. We do not abort if
+   the stream is ended because there is not enough context in this function to
+   give a good error message. The current position is advanced even if the
+   stream has ended because the convention is that the parsing index should sit
+   immediately after the index that gave it trouble; in other words, we parse
+   first, ask questions later. */
+char parse_char() {
+  char c = peek_char();
+  advance_char();
+  return c;
+}
+
+/* Tries to skip past the specified string. If the next characters do not match
+   the string or the stream ends before we find the whole string, we stop
+   advancing and return false. We do not abort on failure because there is not
+   enough context in this function to give a good error message. */
+bool_t parse_exactly(char* string) {
+  size_t i = 0;
+  char parsed_char;
+  while (true) {
+    char string_char = string[i];
+    if (!string_char) {
+      return true;
+    }
+    parsed_char = parse_char();
+    if (parsed_char != string_char) {
+      return false;
+    } else if (!parsed_char) {
+      return true;
+    }
+    i = i + 1;
+  }
+}
+
+/* Which characters belong to each class, indexed by character. Identifiers
+   start with a lowercase letter and go on with lowercase letters, digits and
+   underscores. Characters outside of ASCII belong to none of the classes. */
+u8_t const parse_identifier_rest_chars[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+u8_t const parse_digit_chars[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+u8_t const parse_operator_chars[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 1, 0, 0, 1, 1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+u8_t const parse_whitespace_chars[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* --------------------------------------------------------------------------------
+ * SCANNING
+ *
+ * Runs of whitespace, identifier characters, digits and operator characters,
+ * as well as the ends of declarations, are found with vector instructions, 16
+ * or 32 bytes at a time. The widest variant supported by the processor is
+ * picked once at startup with cpuid; the scalar variant only exists for
+ * completeness, since every x86-64 processor has SSE2.
+ * -------------------------------------------------------------------------------- */
+
+typedef u8_t char_class_t;
+#define char_class_whitespace 0
+#define char_class_identifier 1
+#define char_class_digit 2
+#define char_class_operator 3
+
+typedef char v16_t __attribute__ ((vector_size (16)));
+typedef char v16_unaligned_t __attribute__ ((vector_size (16), aligned (1), may_alias));
+typedef char v32_t __attribute__ ((vector_size (32)));
+typedef char v32_unaligned_t __attribute__ ((vector_size (32), aligned (1), may_alias));
+
+void cpuid(u32_t leaf, u32_t subleaf, u32_t* registers);
+u64_t xgetbv(u32_t index);
+
+u8_t const* const scan_tables[4] = {
+  parse_whitespace_chars,
+  parse_identifier_rest_chars,
+  parse_digit_chars,
+  parse_operator_chars
+};
+
+/* Each scan function returns the index of the first character at or after
+   the given index that is not in the class, or the length if the run extends
+   to the end of the data. */
+size_t scan_scalar(char const* data, size_t index, size_t length, char_class_t class) {
+  u8_t const* table = scan_tables[class];
+  while (index < length && table[(u8_t) data[index]]) {
+    index = index + 1;
+  }
+  return index;
+}
+
+/* Characters outside of ASCII are negative, so they fail every range check. */
+size_t scan_sse2(char const* data, size_t index, size_t length, char_class_t class) {
+  while (index + 16 <= length) {
+    v16_t c = *(v16_unaligned_t const*) &data[index];
+    v16_t in_class;
+    switch (class) {
+      case char_class_whitespace:
+        in_class = (v16_t) ((c == ' ') | (c == '\t') | (c == '\n'));
+        break;
+      case char_class_identifier:
+        in_class = (v16_t) (((c >= 'a') & (c <= 'z')) | ((c >= '0') & (c <= '9')) | (c == '_'));
+        break;
+      case char_class_digit:
+        in_class = (v16_t) ((c >= '0') & (c <= '9'));
+        break;
+      default:
+        in_class = (v16_t) ((c == '<') | (c == '>') | (c == '+') | (c == '-') | (c == '*')
+          | (c == '/') | (c == '=') | (c == '&') | (c == '|') | (c == '$') | (c == '!')
+          | (c == '?') | (c == '^') | (c == '%'));
+        break;
+    }
+    u32_t mask = (u32_t) __builtin_ia32_pmovmskb128(in_class);
+    if (mask != 0xffff) {
+      return index + __builtin_ctz(~mask);
+    }
+    index = index + 16;
+  }
+  return scan_scalar(data, index, length, class);
+}
+
+__attribute__ ((target ("avx2")))
+size_t scan_avx2(char const* data, size_t index, size_t length, char_class_t class) {
+  while (index + 32 <= length) {
+    v32_t c = *(v32_unaligned_t const*) &data[index];
+    v32_t in_class;
+    switch (class) {
+      case char_class_whitespace:
+        in_class = (v32_t) ((c == ' ') | (c == '\t') | (c == '\n'));
+        break;
+      case char_class_identifier:
+        in_class = (v32_t) (((c >= 'a') & (c <= 'z')) | ((c >= '0') & (c <= '9')) | (c == '_'));
+        break;
+      case char_class_digit:
+        in_class = (v32_t) ((c >= '0') & (c <= '9'));
+        break;
+      default:
+        in_class = (v32_t) ((c == '<') | (c == '>') | (c == '+') | (c == '-') | (c == '*')
+          | (c == '/') | (c == '=') | (c == '&') | (c == '|') | (c == '$') | (c == '!')
+          | (c == '?') | (c == '^') | (c == '%'));
+        break;
+    }
+    u32_t mask = (u32_t) __builtin_ia32_pmovmskb256(in_class);
+    if (mask != 0xffffffff) {
+      return index + __builtin_ctz(~mask);
+    }
+    index = index + 32;
+  }
+  return scan_sse2(data, index, length, class);
+}
+
+size_t (*scan)(char const* data, size_t index, size_t length, char_class_t class) = scan_scalar;
+
+/* AVX2 also needs the operating system to save the upper halves of the
+   vector registers, which is what the OSXSAVE and XCR0 checks are for. */
+void scan_init() {
+  u32_t registers[4];
+  cpuid(0, 0, registers);
+  u32_t max_leaf = registers[0];
+  cpuid(1, 0, registers);
+  bool_t has_sse2 = (registers[3] >> 26) & 1;
+  bool_t has_osxsave = (registers[2] >> 27) & 1;
+  bool_t has_avx = (registers[2] >> 28) & 1;
+  bool_t has_avx2 = false;
+  if (max_leaf >= 7 && has_osxsave && has_avx && (xgetbv(0) & 6) == 6) {
+    cpuid(7, 0, registers);
+    has_avx2 = (registers[1] >> 5) & 1;
+  }
+  if (has_avx2) {
+    scan = scan_avx2;
+  } else if (has_sse2) {
+    scan = scan_sse2;
+  } else {
+    scan = scan_scalar;
+  }
+}
+
+/* Counts the newlines between two indices, and sets last_newline to the
+   index of the last one if there are any. */
+size_t scan_count_newlines(char const* data, size_t index, size_t end, size_t* last_newline) {
+  size_t count = 0;
+  while (index + 16 <= end) {
+    v16_t c = *(v16_unaligned_t const*) &data[index];
+    u32_t mask = (u32_t) __builtin_ia32_pmovmskb128((v16_t) (c == '\n'));
+    if (mask) {
+      *last_newline = index + 31 - __builtin_clz(mask);
+      while (mask) {
+        mask = mask & (mask - 1);
+        count = count + 1;
+      }
+    }
+    index = index + 16;
+  }
+  while (index < end) {
+    if (data[index] == '\n') {
+      *last_newline = index;
+      count = count + 1;
+    }
+    index = index + 1;
+  }
+  return count;
+}
+
+/* Returns the index of the first a or b at or after the given index, or the
+   length if there is neither. */
+size_t scan_find(char const* data, size_t index, size_t length, char a, char b) {
+  while (index + 16 <= length) {
+    v16_t c = *(v16_unaligned_t const*) &data[index];
+    u32_t mask = (u32_t) __builtin_ia32_pmovmskb128((v16_t) ((c == a) | (c == b)));
+    if (mask) {
+      return index + __builtin_ctz(mask);
+    }
+    index = index + 16;
+  }
+  while (index < length && data[index] != a && data[index] != b) {
+    index = index + 1;
+  }
+  return index;
+}
+
+/* -------------------------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------------------
+ * LEXING
+ *
+ * Before a declaration is parsed, a separate pass turns its characters into
+ * tokens, which are kept as parallel arrays of kinds, values and offsets. The
+ * arrays only hold a small window of tokens, so that they stay in the L1 cache;
+ * when the parser reaches the end of the window, the next tokens are lexed into
+ * it. Identifiers, operators and literals are interned as they are lexed, so
+ * the parser mostly deals with string ids rather than characters.
+ *
+ * The grammar cares about whitespace in a few places, such as between a type
+ * and its modifiers, so each token notes whether whitespace comes before it.
+ * The only place that is lexed differently is a type: a '*' right after the
+ * name of a type or one of its modifiers is a modifier rather than the start of
+ * an operator.
+ * -------------------------------------------------------------------------------- */
+
+typedef u8_t token_kind_t;
+#define token_kind_end 0
+#define token_kind_identifier 1
+/* Digits with a suffix, like 12u8, whose value is the whole literal. */
+#define token_kind_literal 2
+/* Digits without a suffix, which have no value. */
+#define token_kind_digits 3
+#define token_kind_operator 4
+#define token_kind_invalid 5
+/* Any other printable character is a token by itself, whose kind is the
+   character. The kinds of tokens with whitespace before them are marked with
+   TOKEN_SPACED. */
+#define TOKEN_SPACED 0x80
+#define LEX_NO_LIMIT ((size_t) -1)
+
+/* The kind of token that each character starts: 1 for identifiers, 3 for
+   digits, 4 for operators and 5 for invalid characters, and the character
+   itself for any other printable one. A zero byte is treated like the end of
+   the file. */
+token_kind_t const lex_char_kinds[256] = {
+  0, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  5, 4, '"', '#', 4, 4, 4, '\'', '(', ')', 4, 4, ',', 4, '.', 4,
+  3, 3, 3, 3, 3, 3, 3, 3, 3, 3, ':', ';', 4, 4, 4, 4,
+  '@', 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O',
+  'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', '[', '\\', ']', 4, '_',
+  '`', 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, '{', 4, '}', '~', 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5
+};
+
+__thread token_kind_t lex_kinds[LEX_WINDOW_LENGTH];
+__thread strings_id_t lex_values[LEX_WINDOW_LENGTH];
+__thread size_t lex_offsets[LEX_WINDOW_LENGTH];
+__thread size_t lex_count = 0;
+/* The token the parser is at. */
+__thread size_t lex_index = 0;
+
+/* Where the next window starts, which is right after the last token lexed. */
+__thread size_t lex_resume = 0;
+/* Lexing stops after a token of either of these kinds, or once the given
+   number of tokens is lexed. Either way, an end token is added. No token has
+   the kind '\n', so stopping after it instead stops at the end of the line. */
+__thread token_kind_t lex_stop_a;
+__thread token_kind_t lex_stop_b;
+__thread size_t lex_limit;
+__thread bool_t lex_stopped;
+
+/* How far into a type the lexer is: 1 right after '`', 2 after the name or a
+   modifier, 3 inside the length of an array, and 0 outside of types. Lengths
+   are expressions, which can have casts to types with lengths of their own,
+   so the number of lengths the lexer is inside of is kept as well. */
+__thread u8_t lex_type_state = 0;
+__thread size_t lex_type_depth = 0;
+
+/* Checks whether there is a line break in the given part of the data. */
+bool_t lex_has_newline(char const* data, size_t start, size_t end) {
+  while (start < end) {
+    if (data[start] == '\n') {
+      return true;
+    }
+    start = start + 1;
+  }
+  return false;
+}
+
+/* Skips to the end of a run of characters of the given class. Most runs are
+   short, so the first few characters are checked one at a time before
+   resorting to a scan. */
+size_t lex_skip(char const* data, size_t index, size_t length, char_class_t class) {
+  u8_t const* table = scan_tables[class];
+  size_t short_end = min_size(index + 16, length);
+  while (index < short_end && table[(u8_t) data[index]]) {
+    index = index + 1;
+  }
+  if (index == short_end) {
+    index = scan(data, index, length, class);
+  }
+  return index;
+}
+
+void lex_fill() {
+  measure_phase_t previous_phase = measure_switch(measure_phase_lex);
+  char const* data = parse_read_buffer;
+  size_t length = parse_read_buffer_length;
+  token_kind_t* kinds = lex_kinds;
+  strings_id_t* values = lex_values;
+  size_t* offsets = lex_offsets;
+  token_kind_t stop_a = lex_stop_a;
+  token_kind_t stop_b = lex_stop_b;
+  size_t limit = lex_limit;
+  u8_t type_state = lex_type_state;
+  size_t type_depth = lex_type_depth;
+  size_t index = lex_resume;
+  size_t count = 0;
+  bool_t stopped = false;
+  /* One place is kept for the end token. */
+  while (count < LEX_WINDOW_LENGTH - 1) {
+    size_t start = index;
+    if (index < length && parse_whitespace_chars[(u8_t) data[index]]) {
+      index = lex_skip(data, index + 1, length, char_class_whitespace);
+    }
+    token_kind_t spaced = index != start ? TOKEN_SPACED : 0;
+    if (limit == 0 || (spaced && stop_a == '\n' && lex_has_newline(data, start, index))) {
+      kinds[count] = token_kind_end | spaced;
+      offsets[count] = index;
+      count = count + 1;
+      stopped = true;
+      break;
+    }
+    u8_t c = index < length ? (u8_t) data[index] : 0;
+    token_kind_t kind = lex_char_kinds[c];
+    strings_id_t value = 0;
+    size_t end = index + 1;
+    if (kind == token_kind_identifier) {
+      /* Tokens are short, so they are hashed one character at a time while
+         looking for their end, instead of being scanned first. */
+      u32_t hash = strings_hash_step(FNV_OFFSET_BASIS, (char) c);
+      while (end < length && parse_identifier_rest_chars[(u8_t) data[end]]) {
+        hash = strings_hash_step(hash, data[end]);
+        end = end + 1;
+      }
+      value = strings_id_hashed(&data[index], end - index, hash);
+    } else if (kind == token_kind_digits) {
+      u32_t hash = strings_hash_step(FNV_OFFSET_BASIS, (char) c);
+      while (end < length && parse_digit_chars[(u8_t) data[end]]) {
+        hash = strings_hash_step(hash, data[end]);
+        end = end + 1;
+      }
+      if (end + 1 < length && (data[end] == 'i' || data[end] == 'u') && parse_digit_chars[(u8_t) data[end + 1]]) {
+        hash = strings_hash_step(hash, data[end]);
+        end = end + 1;
+        while (end < length && parse_digit_chars[(u8_t) data[end]]) {
+          hash = strings_hash_step(hash, data[end]);
+          end = end + 1;
+        }
+        kind = token_kind_literal;
+        value = strings_id_hashed(&data[index], end - index, hash);
+      }
+    } else if (kind == token_kind_operator) {
+      if (c == '*' && type_state == 2 && !spaced) {
+        kind = '*';
+      } else {
+        u32_t hash = strings_hash_step(FNV_OFFSET_BASIS, (char) c);
+        while (end < length && parse_operator_chars[(u8_t) data[end]]) {
+          hash = strings_hash_step(hash, data[end]);
+          end = end + 1;
+        }
+        value = strings_id_hashed(&data[index], end - index, hash);
+      }
+    } else if (kind == token_kind_end) {
+      end = index;
+      stopped = true;
+    }
+    if (kind == '`') {
+      type_state = 1;
+    } else if (type_state != 0) {
+      if (type_state == 1 && kind == token_kind_identifier && !spaced) {
+        type_state = 2;
+      } else if (type_state == 2 && (kind == '*' || kind == '[') && !spaced) {
+        if (kind == '[') {
+          type_state = 3;
+          type_depth = type_depth + 1;
+        }
+      } else if (type_depth == 0) {
+        type_state = 0;
+      } else if (kind == ']') {
+        type_state = 2;
+        type_depth = type_depth - 1;
+      } else {
+        type_state = 3;
+      }
+    }
+    kinds[count] = kind | spaced;
+    values[count] = value;
+    offsets[count] = index;
+    count = count + 1;
+    index = end;
+    limit = limit - 1;
+    if (stopped) {
+      break;
+    }
+    if (kind == stop_a || kind == stop_b) {
+      kinds[count] = token_kind_end;
+      offsets[count] = index;
+      count = count + 1;
+      stopped = true;
+      break;
+    }
+  }
+  lex_limit = limit;
+  lex_type_state = type_state;
+  lex_type_depth = type_depth;
+  lex_stopped = stopped;
+  lex_count = count;
+  lex_index = 0;
+  lex_resume = index;
+  measure_switch(previous_phase);
+}
+
+/* Starts lexing at the given index. */
+void lex_start(size_t index, token_kind_t stop_a, token_kind_t stop_b, size_t limit) {
+  lex_resume = index;
+  lex_stop_a = stop_a;
+  lex_stop_b = stop_b;
+  lex_limit = limit;
+  lex_stopped = false;
+  lex_type_state = 0;
+  lex_type_depth = 0;
+  lex_fill();
+}
+
+token_kind_t lex_kind() {
+  return lex_kinds[lex_index] & ~TOKEN_SPACED;
+}
+
+/* Whether there is whitespace right before the current token. */
+bool_t lex_spaced() {
+  return (lex_kinds[lex_index] & TOKEN_SPACED) != 0;
+}
+
+strings_id_t lex_value() {
+  return lex_values[lex_index];
+}
+
+size_t lex_offset() {
+  return lex_offsets[lex_index];
+}
+
+/* Moves on to the next token. The parser never moves past an end token. */
+void lex_advance() {
+  lex_index = lex_index + 1;
+  if (lex_index == lex_count && !lex_stopped) {
+    lex_fill();
+  }
+}
+
+/* -------------------------------------------------------------------------------- */
+
+/* Determines whether the given character is a whitespace character. */
+bool_t parse_is_whitespace(char c) {
+  switch (c) {
+    case ' ':
+    case '\t':
+    case '\n': return true;
+    default: return false;
+  }
+}
+
+/* Skips past whitespace, if there is any. */
+void parse_skip_whitespace() {
+  current_location.index = scan(parse_read_buffer, current_location.index, parse_read_buffer_length, char_class_whitespace);
+}
+
+/* Skips past whitespace, but aborting if there is no whitespace to be found. */
+void parse_skip_whitespace1() {
+  if (parse_is_whitespace(parse_char())) {
+    parse_skip_whitespace();
+  } else {
+    parse_log_current_location();
+    log_line("Expected whitespace.");
+    parse_log_current_location_line_with_column_marker();
+    syscall_exit(1);
+  }
+}
+
+void parse_error_expected_declaration_start_keyword() {
+  parse_log_current_location();
+  log_line("Expected 'struct', 'const', or 'fn' to begin declaration.");
+  parse_log_current_location_line_with_column_marker();
+  syscall_exit(1);
+}
+
+void parse_error_expected_control_flow_keyword() {
+  parse_log_current_location();
+  log_line("Expected statement.");
+  parse_log_current_location_line_with_column_marker();
+  syscall_exit(1);
+}
+
+void parse_error_expected_identifier() {
+  parse_log_current_location();
+  log_line("Expected identifier.");
+  parse_log_current_location_line_with_column_marker();
+  syscall_exit(1);
+}
+
+void parse_error_expected_integer_constant() {
+  parse_log_current_location();
+  log_line("Expected literal or named integer constant.");
+  parse_log_current_location_line_with_column_marker();
+  syscall_exit(1);
+}
+
+void parse_error_expected_operand() {
+  parse_log_current_location();
+  log_line("Expected identifier, number literal, or '('.");
+  parse_log_current_location_line_with_column_marker();
+  syscall_exit(1);
+}
+
+strings_id_t parse_permanent_identifier() {
+  if (lex_kind() == token_kind_identifier) {
+    strings_id_t name = lex_value();
+    lex_advance();
+    return name;
+  } else {
+    current_location.index = lex_offset() + 1;
+    parse_error_expected_identifier();
+    return 0;
+  }
+}
+
+u64_t array_lengths[MAX_ARRAY_LENGTHS];
+size_t array_lengths_index = 0;
+
+typedef struct type_t {
+  /* The named type from which this type is derived. */
+  strings_id_t base;
+  /* For example, i32*** has three modifiers (each pointer is a modifier). */
+  u8_t modifier_count;
+  /* The modifier_count least significant bits say whether each modifier is a pointer (0) or an array (1) */
+  u8_t modifiers;
+  /* If any of the modifiers are arrays, then the lengths of those arrays will
+     be stored in array_lengths, starting at first_array_length_index. */
+  u16_t first_array_length_index;
+} type_t;
+
+typedef struct struct_field_t {
+  strings_id_t name;
+  type_t type;
+} struct_field_t;
+
+typedef struct struct_info_t {
+  u16_t field_count;
+  u16_t first_field_index;
+  bool_t exists;
+} struct_info_t;
+
+struct_field_t struct_fields[MAX_STRUCT_FIELDS];
+size_t struct_fields_index = 0;
+struct_info_t* struct_infos = 0;
+
+typedef struct parse_local_variable_t {
+  strings_id_t name;
+  type_t type;
+} parse_local_variable_t;
+
+/* The arguments of a function are kept in parse_fn_arguments, which only
+   grows, starting at first_argument. */
+typedef struct parse_fn_signature_t {
+  u8_t arity;
+  u32_t first_argument;
+  type_t return_type;
+} parse_fn_signature_t;
+
+parse_local_variable_t* parse_fn_arguments = 0;
+size_t parse_fn_arguments_count = 0;
+
+/* Few names are functions, so their signatures are kept densely, in the
+   order they are first declared, and parse_fn_signature_indexes maps each
+   name to its signature, or to 0 if it isn't a function. */
+parse_fn_signature_t* parse_fn_signatures = 0;
+size_t parse_fn_signatures_count = 1;
+u32_t* parse_fn_signature_indexes = 0;
+
+/* Returns the signature of the function with the given name, or 0 if there is
+   no such function. */
+parse_fn_signature_t* parse_find_fn(strings_id_t name) {
+  u32_t index = parse_fn_signature_indexes[name];
+  return index ? &parse_fn_signatures[index] : 0;
+}
+
+typedef struct parse_constant_t {
+  bool_t exists;
+  u64_t value;
+} parse_constant_t;
+
+parse_constant_t* parse_constants = 0;
+
+typedef u8_t declaration_kind_t;
+#define declaration_kind_struct 0
+#define declaration_kind_const 1
+#define declaration_kind_fn 2
+
+/* Each declaration has an ordinal, with the index of its file in the upper
+   half and its position in the file, counting from one, in the lower half.
+   The ordinal of the earliest declaration of each name is kept for each kind
+   of declaration, or 0 if there is none. */
+__thread u64_t parse_declaration_ordinal = 0;
+u64_t* parse_declaration_ordinals[3];
+/* Where the header of each of those declarations ends, so that it can be
+   skipped when the declaration is parsed again. */
+size_t* parse_declaration_ends[3];
+
+/* Before any function body is parsed, the declarations in all of the input
+   files are parsed once while skipping the bodies, which is called
+   prescanning. That way, code can use what is declared after it, including in
+   later files. */
+bool_t parse_prescanning = false;
+char const** parse_filenames = 0;
+
+/* The chunk being translated. Chunks are defined along with the driver. */
+__thread u32_t parse_chunk_index = 0;
+
+/* The functions that the function being parsed calls before they are
+   declared, which need prototypes in front of it. Each function only gets one
+   prototype per chunk, which parse_prototype_chunks keeps track of by storing
+   the index of the chunk plus one. Chunks only depend on the input, so the
+   output is the same with any number of threads. */
+__thread strings_id_t* parse_forward_calls;
+__thread size_t parse_forward_calls_count = 0;
+__thread u32_t* parse_prototype_chunks;
+
+bool_t parse_types_agree(type_t a, type_t b) {
+  if (a.base != b.base || a.modifier_count != b.modifier_count || a.modifiers != b.modifiers) {
+    return false;
+  }
+  size_t array_length_index = 0;
+  u8_t i = 0;
+  while (i < a.modifier_count) {
+    if (a.modifiers & (1 << i)) {
+      if (array_lengths[a.first_array_length_index + array_length_index] != array_lengths[b.first_array_length_index + array_length_index]) {
+        return false;
+      }
+      array_length_index = array_length_index + 1;
+    }
+    i = i + 1;
+  }
+  return true;
+}
+
+/* The names of the arguments are not part of the agreement, since they don't
+   matter to callers. */
+bool_t parse_fn_signatures_agree(parse_fn_signature_t const* a, parse_fn_signature_t const* b) {
+  if (a->arity != b->arity || !parse_types_agree(a->return_type, b->return_type)) {
+    return false;
+  }
+  u16_t i = 0;
+  while (i < a->arity) {
+    if (!parse_types_agree(parse_fn_arguments[a->first_argument + i].type, parse_fn_arguments[b->first_argument + i].type)) {
+      return false;
+    }
+    i = i + 1;
+  }
+  return true;
+}
+
+bool_t parse_struct_infos_agree(struct_info_t a, struct_info_t b) {
+  if (a.field_count != b.field_count) {
+    return false;
+  }
+  u16_t i = 0;
+  while (i < a.field_count) {
+    struct_field_t field_a = struct_fields[a.first_field_index + i];
+    struct_field_t field_b = struct_fields[b.first_field_index + i];
+    if (field_a.name != field_b.name || !parse_types_agree(field_a.type, field_b.type)) {
+      return false;
+    }
+    i = i + 1;
+  }
+  return true;
+}
+
+/* Decides whether the declaration being parsed replaces the record for its
+   name. When prescanning, the earliest declaration is kept, since it is the
+   one that code before all of the declarations sees. After that, each
+   declaration replaces the record as it is parsed again, except with '-j',
+   where the records are left as they are, because the declarations of a name
+   have to agree. That is checked while prescanning. */
+bool_t parse_replaces_declaration(declaration_kind_t kind, strings_id_t name, bool_t exists, bool_t agrees) {
+  if (!parse_prescanning) {
+    return !threads_enabled;
+  }
+  u64_t* ordinal = &parse_declaration_ordinals[kind][name];
+  if (exists) {
+    if (threads_enabled && !agrees) {
+      u32_t first_file = *ordinal >> 32;
+      u32_t second_file = parse_declaration_ordinal >> 32;
+      if (second_file < first_file) {
+        second_file = first_file;
+        first_file = parse_declaration_ordinal >> 32;
+      }
+      log_string("The declarations of '");
+      log_string(strings_pointers[name]);
+      log_string("' in \"");
+      log_string(parse_filenames[first_file]);
+      if (second_file != first_file) {
+        log_string("\" and \"");
+        log_string(parse_filenames[second_file]);
+      }
+      log_line("\" do not agree, which is only allowed without '-j'.");
+      syscall_exit(1);
+    }
+    if (*ordinal <= parse_declaration_ordinal) {
+      return false;
+    }
+  }
+  *ordinal = parse_declaration_ordinal;
+  parse_declaration_ends[kind][name] = current_location.index;
+  return true;
+}
+
+/* Returns true if the declaration being parsed is the one whose record was kept
+   while prescanning, in which case its header is skipped, since the record
+   already holds everything in it. The header is still parsed while recording
+   a cache entry, which depends on the constants in it. */
+extern bool_t cache_recording;
+
+bool_t parse_skip_prescanned(declaration_kind_t kind, strings_id_t name) {
+  if (cache_recording || parse_declaration_ordinals[kind][name] != parse_declaration_ordinal) {
+    return false;
+  }
+  current_location.index = parse_declaration_ends[kind][name];
+  return true;
+}
+
+void parse_declare_struct(strings_id_t name, struct_info_t info) {
+  struct_info_t* record = &struct_infos[name];
+  bool_t agrees = !record->exists || !threads_enabled || parse_struct_infos_agree(*record, info);
+  if (parse_replaces_declaration(declaration_kind_struct, name, record->exists, agrees)) {
+    *record = info;
+  }
+}
+
+void parse_declare_constant(strings_id_t name, u64_t value) {
+  parse_constant_t* record = &parse_constants[name];
+  bool_t agrees = !record->exists || record->value == value;
+  if (parse_replaces_declaration(declaration_kind_const, name, record->exists, agrees)) {
+    *record = (parse_constant_t) { .exists = true, .value = value };
+  }
+}
+
+void parse_declare_fn(strings_id_t name, parse_fn_signature_t const* signature) {
+  parse_fn_signature_t* record = parse_find_fn(name);
+  bool_t agrees = !record || !threads_enabled || parse_fn_signatures_agree(record, signature);
+  if (parse_replaces_declaration(declaration_kind_fn, name, record != 0, agrees)) {
+    if (!record) {
+      size_t index = threads_reserve(&parse_fn_signatures_count, 1);
+      ensure_array_space(index, limit_strings, "parse_fn_signatures");
+      parse_fn_signature_indexes[name] = index;
+      record = &parse_fn_signatures[index];
+    }
+    *record = *signature;
+  }
+}
+
+/* Adds array lengths, struct fields or function arguments to the end of the
+   shared arrays, and returns the index of the first one. */
+size_t parse_add_array_lengths(u64_t const* lengths, size_t count) {
+  size_t first = threads_reserve(&array_lengths_index, count);
+  if (count) {
+    ensure_array_space(first + count - 1, MAX_ARRAY_LENGTHS, "array_lengths");
+  }
+  copy_bytes(&array_lengths[first], lengths, count * sizeof(u64_t));
+  return first;
+}
+
+size_t parse_add_struct_fields(struct_field_t const* fields, size_t count) {
+  size_t first = threads_reserve(&struct_fields_index, count);
+  if (count) {
+    ensure_array_space(first + count - 1, MAX_STRUCT_FIELDS, "struct_fields");
+  }
+  copy_bytes(&struct_fields[first], fields, count * sizeof(struct_field_t));
+  return first;
+}
+
+size_t parse_reserve_fn_arguments(size_t count) {
+  size_t first = threads_reserve(&parse_fn_arguments_count, count);
+  if (count) {
+    ensure_array_space(first + count - 1, limit_fn_arguments, "parse_fn_arguments");
+  }
+  return first;
+}
+
+size_t parse_add_fn_arguments(parse_local_variable_t const* arguments, size_t count) {
+  size_t first = parse_reserve_fn_arguments(count);
+  copy_bytes(&parse_fn_arguments[first], arguments, count * sizeof(parse_local_variable_t));
+  return first;
+}
+
+/* Defined with the cache, which needs to know which functions and constants
+   each function depends on. */
+void cache_depend_on_fn(strings_id_t name);
+void cache_depend_on_constant(strings_id_t name);
+
+/* Parses the digits at the current location, which have to be representable
+   in 64 bits, and leaves the current location right after them. */
+u64_t parse_digits() {
+  size_t c = (size_t) peek_char();
+  advance_char();
+  u64_t current = c - '0';
+  while (true) {
+    c = (size_t) peek_char();
+    if (parse_digit_chars[c]) {
+      advance_char();
+      size_t next = current * 10 + c - '0';
+      /* If incorporating a digit causes the accumulated value to go down, then
+        we must have overflowed, which means the literal denotes an
+        unrepresentable integer (at least, it is unrepresentable in 64 bits,
+        which is the size we care about).. */
+      if (next < current) {
+        parse_log_current_location();
+        log_line("Integer constant too large; it must be representable in 64 bits.");
+        parse_log_current_location_line_with_column_marker();
+        syscall_exit(1);
+      }
+      current = next;
+    } else {
+      break;
+    }
+  }
+  return current;
+}
+
+/* Defined after expressions, since it parses one. */
+u64_t parse_constant_expression();
+
+typedef u8_t expression_kind_t;
+#define expression_kind_operation 0
+#define expression_kind_operator 1
+#define expression_kind_integer 2
+#define expression_kind_local 3
+#define expression_kind_constant 4
+#define expression_kind_cast 5
+#define expression_kind_ascription 6
+
+__thread parse_local_variable_t parse_local_variables[MAX_LOCAL_VARIABLES];
+__thread size_t parse_local_variables_index = 0;
+
+/* The innermost local variable bound to each name, as an index into
+   parse_local_variables plus one, or 0 if the name is not bound. When a local
+   variable is added, the binding it replaces is saved in
+   parse_local_variables_shadowed, so that the binding can be restored when the
+   local variable goes out of scope. */
+__thread u32_t* parse_local_bindings;
+__thread u32_t parse_local_variables_shadowed[MAX_LOCAL_VARIABLES];
+/* The most local variables that were in scope at once since the statistics
+   last noted a declaration. */
+__thread size_t parse_local_variables_peak = 0;
+
+/* Returns the index of the local variable with the given name, or
+   parse_local_variables_index if there is no such variable in scope. */
+size_t parse_find_local_variable(strings_id_t name) {
+  u32_t binding = parse_local_bindings[name];
+  if (binding) {
+    return binding - 1;
+  }
+  return parse_local_variables_index;
+}
+
+void parse_add_local_variable(parse_local_variable_t variable) {
+  ensure_array_space(parse_local_variables_index, MAX_LOCAL_VARIABLES, "parse_local_variables");
+  parse_local_variables[parse_local_variables_index] = variable;
+  parse_local_variables_shadowed[parse_local_variables_index] = parse_local_bindings[variable.name];
+  parse_local_variables_index = parse_local_variables_index + 1;
+  parse_local_bindings[variable.name] = parse_local_variables_index;
+  if (parse_local_variables_index > parse_local_variables_peak) {
+    parse_local_variables_peak = parse_local_variables_index;
+  }
+}
+
+/* Removes the local variables from the given index onwards, most recent first,
+   so that each name is bound to whatever it was bound to before. */
+void parse_remove_local_variables(size_t first_local_variable) {
+  work_counts[work_steps] = work_counts[work_steps] + parse_local_variables_index - first_local_variable;
+  while (parse_local_variables_index > first_local_variable) {
+    parse_local_variables_index = parse_local_variables_index - 1;
+    strings_id_t name = parse_local_variables[parse_local_variables_index].name;
+    parse_local_bindings[name] = parse_local_variables_shadowed[parse_local_variables_index];
+  }
+}
+
+typedef union expression_data_t {
+  /* Data is the id for one of (a) the name of the operation or operator, (b)
+    the identifier, or (c) the digits of the integer, depending on the kind. */
+  strings_id_t name;
+  /* Type is active when the kind is cast or ascription, in which case it is
+      the type being ascribed or casted to. */
+  type_t type;
+} expression_data_t;
+
+typedef struct expression_t {
+  expression_kind_t kind;
+  /* Arity is the number of child expression. It is needed for function calls
+     and for operators, since a chain of the same operator is a single
+     expression. */
+  u8_t arity;
+  /* The number of expressions in the subtree rooted at this expression,
+     including itself. */
+  u32_t size;
+  expression_data_t data;
+} expression_t;
+
+/* Expressions are stored in postfix order: the operands of an expression come
+   right before it, so an expression is only added once all of its operands
+   have been parsed, and nothing ever has to be moved. The last operand of the
+   expression at index i is rooted at i - 1, and each earlier operand is rooted
+   just before the subtree of the operand after it. */
+__thread expression_t* parse_expressions;
+__thread size_t parse_expression_index = 0;
+
+/* Adds an expression whose operands are the expressions from first_index up
+   to the current end of the array. */
+void parse_add_expression(expression_kind_t kind, u8_t arity, expression_data_t data, size_t first_index) {
+  ensure_array_space(parse_expression_index, limit_expressions, "parse_expressions");
+  parse_expressions[parse_expression_index] = (expression_t) {
+    .kind = kind,
+    .arity = arity,
+    .size = parse_expression_index - first_index + 1,
+    .data = data
+  };
+  parse_expression_index = parse_expression_index + 1;
+}
+
+type_t parse_type() {
+  if (lex_kind() != '`') {
+    current_location.index = lex_offset() + 1;
+    parse_log_current_location();
+    log_line("Expected '`' to begin type.");
+    parse_log_current_location_line_with_column_marker();
+    syscall_exit(1);
+  }
+  size_t backtick = lex_offset();
+  lex_advance();
+  if (lex_spaced()) {
+    current_location.index = backtick + 2;
+    parse_error_expected_identifier();
+  }
+  strings_id_t base = parse_permanent_identifier();
+  type_t result = {
+    .base = base,
+    .modifier_count = 0,
+    .modifiers = 0
+  };
+  /* The lengths are only added to array_lengths once the whole type is
+     parsed, so that they are consecutive even if other threads add lengths in
+     the meantime. */
+  u64_t lengths[MAX_TYPE_MODIFIERS];
+  size_t length_count = 0;
+  while (true) {
+    /* Modifiers have to come right after the type, so a spaced token doesn't
+       match either kind. */
+    token_kind_t kind = lex_kinds[lex_index];
+    if (kind == '*' || kind == '[') {
+      if (result.modifier_count == MAX_TYPE_MODIFIERS) {
+        current_location.index = lex_offset() + 1;
+        parse_log_current_location();
+        log_line("Types can have at most 8 pointer or array modifiers.");
+        parse_log_current_location_line_with_column_marker();
+        syscall_exit(1);
+      }
+    }
+    if (kind == '*') {
+      lex_advance();
+      result.modifier_count = result.modifier_count + 1;
+    } else if (kind == '[') {
+      size_t bracket = lex_offset();
+      lex_advance();
+      result.modifiers = result.modifiers | (1 << result.modifier_count);
+      result.modifier_count = result.modifier_count + 1;
+      if (lex_spaced()) {
+        current_location.index = bracket + 1;
+        parse_error_expected_integer_constant();
+      }
+      lengths[length_count] = parse_constant_expression();
+      length_count = length_count + 1;
+      if (lex_kinds[lex_index] != ']') {
+        current_location.index = current_location.index + 1;
+        parse_log_current_location();
+        log_line("Expected ']' after array size.");
+        parse_log_current_location_line_with_column_marker();
+        syscall_exit(1);
+      }
+      lex_advance();
+    } else {
+      break;
+    }
+  }
+  result.first_array_length_index = parse_add_array_lengths(lengths, length_count);
+  return result;
+}
+
+/* Operators are parsed by precedence climbing over an explicit stack instead
+   of by recursion, so the depth of an expression is limited only by the sizes
+   of the arrays below. Nesting through groups and call arguments is tracked
+   with frames, and each frame has its own run of pending operators.
+
+   A run of the same operator, like 'a + b + c', becomes a single operator
+   expression with one operand per term, rather than a nest of binary ones.
+   Operators with equal precedence associate to the left, and chains are
+   split once they reach the largest arity that fits in an expression. */
+typedef u8_t parse_frame_kind_t;
+#define parse_frame_kind_expression 0
+#define parse_frame_kind_group 1
+#define parse_frame_kind_call 2
+
+typedef struct parse_frame_t {
+  parse_frame_kind_t kind;
+  /* Only used by calls. */
+  u8_t arity;
+  u8_t arguments;
+  strings_id_t name;
+  /* The index of the first expression inside of the frame. */
+  u32_t first_index;
+  /* The index of the first pending operator that belongs to the frame. */
+  u32_t first_operator;
+} parse_frame_t;
+
+typedef struct parse_pending_operator_t {
+  strings_id_t name;
+  u8_t precedence;
+  u8_t operand_count;
+  /* The index of the first expression of the first operand. */
+  u32_t first_index;
+} parse_pending_operator_t;
+
+__thread parse_frame_t* parse_frames;
+__thread size_t parse_frames_index = 0;
+
+__thread parse_pending_operator_t* parse_pending_operators;
+__thread size_t parse_pending_operators_index = 0;
+
+/* The index of the first expression of the most recently completed operand. */
+__thread size_t parse_operand_start = 0;
+
+/* Set while parsing an expression that is evaluated while translating, in
+   which names only refer to constants and digits need no suffix. */
+__thread bool_t parse_constant_context = false;
+
+void parse_push_frame(parse_frame_kind_t kind, u8_t arity, strings_id_t name) {
+  ensure_array_space(parse_frames_index, limit_expression_nesting, "parse_frames");
+  parse_frames[parse_frames_index] = (parse_frame_t) {
+    .kind = kind,
+    .arity = arity,
+    .arguments = 0,
+    .name = name,
+    .first_index = parse_expression_index,
+    .first_operator = parse_pending_operators_index
+  };
+  parse_frames_index = parse_frames_index + 1;
+}
+
+/* Turns the innermost pending operator into an expression, which then becomes
+   the most recently completed operand. */
+void parse_reduce_operator() {
+  parse_pending_operators_index = parse_pending_operators_index - 1;
+  parse_pending_operator_t operator = parse_pending_operators[parse_pending_operators_index];
+  parse_add_expression(expression_kind_operator, operator.operand_count, (expression_data_t) { .name = operator.name }, operator.first_index);
+  parse_operand_start = operator.first_index;
+}
+
+void parse_reduce_operators(size_t first_operator) {
+  while (parse_pending_operators_index > first_operator) {
+    parse_reduce_operator();
+  }
+}
+
+/* Called after the operator between the most recently completed operand and
+   the next one has been parsed. */
+void parse_push_operator(strings_id_t name) {
+  u8_t precedence = name < BUILTIN_STRINGS_COUNT ? builtin_strings_precedences[name] : 0;
+  size_t first_operator = parse_frames[parse_frames_index - 1].first_operator;
+  while (parse_pending_operators_index > first_operator) {
+    parse_pending_operator_t* top = &parse_pending_operators[parse_pending_operators_index - 1];
+    if (top->name == name && top->operand_count < MAX_OPERATOR_CHAIN_LENGTH) {
+      top->operand_count = top->operand_count + 1;
+      return;
+    } else if (top->precedence >= precedence) {
+      parse_reduce_operator();
+    } else {
+      break;
+    }
+  }
+  ensure_array_space(parse_pending_operators_index, limit_expression_nesting, "parse_pending_operators");
+  parse_pending_operators[parse_pending_operators_index] = (parse_pending_operator_t) {
+    .name = name,
+    .precedence = precedence,
+    .operand_count = 2,
+    .first_index = parse_operand_start
+  };
+  parse_pending_operators_index = parse_pending_operators_index + 1;
+}
+
+void parse_error_expected_call_end(strings_id_t name, u8_t arity) {
+  parse_log_current_location();
+  log_string("Expected ')' because the function '");
+  log_string(strings_pointers[name]);
+  log_string("' has arity ");
+  log_size((size_t) arity);
+  log_line(".");
+  parse_log_current_location_line_with_column_marker();
+  syscall_exit(1);
+}
+
+/* Parses the ')' that ends a call and adds the call expression. */
+void parse_close_call(strings_id_t name, u8_t arity, size_t first_index) {
+  if (lex_kind() != ')') {
+    current_location.index = lex_offset() + 1;
+    parse_error_expected_call_end(name, arity);
+  }
+  lex_advance();
+  parse_add_expression(expression_kind_operation, arity, (expression_data_t) { .name = name }, first_index);
+  parse_operand_start = first_index;
+}
+
+void parse_note_call(strings_id_t name) {
+  u32_t chunk = parse_chunk_index + 1;
+  if (parse_declaration_ordinals[declaration_kind_fn][name] > parse_declaration_ordinal && parse_prototype_chunks[name] != chunk) {
+    parse_prototype_chunks[name] = chunk;
+    parse_forward_calls[parse_forward_calls_count] = name;
+    parse_forward_calls_count = parse_forward_calls_count + 1;
+  }
+}
+
+/* Called at the '(' of a call. Returns true if the call is already complete
+   because the function takes no arguments, otherwise opens a frame for the
+   arguments. */
+bool_t parse_open_call(size_t name_offset, strings_id_t name) {
+  size_t parenthesis = lex_offset();
+  lex_advance();
+  parse_fn_signature_t const* fn = parse_find_fn(name);
+  if (!fn) {
+    current_location.index = name_offset + 1;
+    parse_log_current_location();
+    log_string("Unknown function '");
+    log_string(strings_pointers[name]);
+    log_line("'.");
+    parse_log_current_location_line_with_column_marker();
+    syscall_exit(1);
+  }
+  cache_depend_on_fn(name);
+  parse_note_call(name);
+  /* What follows the '(' has to come right after it, so whitespace there is
+     reported where it starts. */
+  bool_t spaced = lex_spaced();
+  if (fn->arity == 0) {
+    if (spaced) {
+      current_location.index = parenthesis + 2;
+      parse_error_expected_call_end(name, 0);
+    }
+    parse_close_call(name, 0, parse_expression_index);
+    return true;
+  }
+  parse_push_frame(parse_frame_kind_call, fn->arity, name);
+  if (spaced) {
+    current_location.index = parenthesis + 2;
+    parse_error_expected_operand();
+  }
+  return false;
+}
+
+/* Parses operands and operators until the frame at index bottom is closed. If
+   operand_complete is true, an operand was already parsed before calling. */
+void parse_expression_frames(size_t bottom, bool_t operand_complete) {
+  while (true) {
+    if (!operand_complete) {
+      parse_operand_start = parse_expression_index;
+      token_kind_t next = lex_kind();
+      if (next == token_kind_identifier) {
+        size_t name_offset = lex_offset();
+        strings_id_t name = lex_value();
+        lex_advance();
+        if (lex_kind() == '(') {
+          if (parse_constant_context) {
+            current_location.index = name_offset + 1;
+            parse_log_current_location();
+            log_line("Functions can't be called in constant expressions.");
+            parse_log_current_location_line_with_column_marker();
+            syscall_exit(1);
+          }
+          if (!parse_open_call(name_offset, name)) {
+            continue;
+          }
+        } else {
+          bool_t found_name = false;
+          expression_kind_t kind;
+          if (!parse_constant_context && parse_find_local_variable(name) < parse_local_variables_index) {
+            found_name = true;
+            kind = expression_kind_local;
+          }
+          if (!found_name && parse_constants[name].exists) {
+            found_name = true;
+            kind = expression_kind_constant;
+            cache_depend_on_constant(name);
+          }
+          if (found_name) {
+            parse_add_expression(kind, 0, (expression_data_t) { .name = name }, parse_expression_index);
+          } else if (parse_constant_context) {
+            current_location.index = name_offset + strings_lengths[name];
+            parse_log_current_location();
+            log_string("Unknown integer constant '");
+            log_string(strings_pointers[name]);
+            log_line("'.");
+            parse_log_current_location_line_with_column_marker();
+            syscall_exit(1);
+          } else {
+            current_location.index = name_offset + 1;
+            parse_log_current_location();
+            log_string("Unknown variable '");
+            log_string(strings_pointers[name]);
+            log_line("'.");
+            parse_log_current_location_line_with_column_marker();
+            syscall_exit(1);
+          }
+        }
+      } else if (next == token_kind_literal) {
+        /* The whole literal is interned, suffix included, so that both the value
+           and the type can be recovered from it. */
+        if (parse_constant_context) {
+          current_location.index = lex_offset();
+          parse_digits();
+        }
+        parse_add_expression(expression_kind_integer, 0, (expression_data_t) { .name = lex_value() }, parse_expression_index);
+        lex_advance();
+      } else if (next == token_kind_digits && parse_constant_context) {
+        /* Digits without a suffix are untyped, like named constants. */
+        size_t start = lex_offset();
+        current_location.index = start;
+        parse_digits();
+        strings_id_t digits = strings_id(&parse_read_buffer[start], current_location.index - start);
+        parse_add_expression(expression_kind_integer, 0, (expression_data_t) { .name = digits }, parse_expression_index);
+        lex_advance();
+      } else if (next == token_kind_digits) {
+        current_location.index = scan(parse_read_buffer, lex_offset(), parse_read_buffer_length, char_class_digit);
+        char signedness = parse_char();
+        if (signedness != 'i' && signedness != 'u') {
+          parse_log_current_location();
+          log_line("Expected 'u' or 'i' after digits to specify signedness.");
+          parse_log_current_location_line_with_column_marker();
+          syscall_exit(1);
+        }
+        advance_char();
+        parse_log_current_location();
+        log_line("Expected digits after signedness to specify size.");
+        parse_log_current_location_line_with_column_marker();
+        syscall_exit(1);
+      } else if (next == '(') {
+        size_t parenthesis = lex_offset();
+        lex_advance();
+        parse_push_frame(parse_frame_kind_group, 0, 0);
+        if (lex_spaced()) {
+          current_location.index = parenthesis + 2;
+          parse_error_expected_operand();
+        }
+        continue;
+      } else if (parse_constant_context) {
+        current_location.index = lex_offset();
+        parse_error_expected_integer_constant();
+      } else {
+        current_location.index = lex_offset() + 1;
+        parse_error_expected_operand();
+      }
+    }
+    operand_complete = false;
+    /* Whitespace is allowed before the first cast or ascription, but a chain of
+       them has to be written without any. */
+    token_kind_t kind = lex_kind();
+    while (true) {
+      if (kind == '@') {
+        lex_advance();
+        type_t type = parse_type();
+        parse_add_expression(expression_kind_cast, 1, (expression_data_t) { .type = type }, parse_operand_start);
+      } else if (kind == '`') {
+        type_t type = parse_type();
+        parse_add_expression(expression_kind_ascription, 1, (expression_data_t) { .type = type }, parse_operand_start);
+      } else {
+        break;
+      }
+      kind = lex_kinds[lex_index];
+    }
+    if (lex_kind() == token_kind_operator) {
+      strings_id_t operator_name = lex_value();
+      lex_advance();
+      parse_push_operator(operator_name);
+      continue;
+    }
+    /* There is no operator, so the innermost frame is finished. */
+    parse_frame_t* frame = &parse_frames[parse_frames_index - 1];
+    parse_reduce_operators(frame->first_operator);
+    switch (frame->kind) {
+      case parse_frame_kind_expression:
+        parse_frames_index = parse_frames_index - 1;
+        return;
+      case parse_frame_kind_group:
+        if (lex_kind() != ')') {
+          current_location.index = lex_offset() + 1;
+          parse_log_current_location();
+          log_line("Expected ')' to finish group expression.");
+          parse_log_current_location_line_with_column_marker();
+          syscall_exit(1);
+        }
+        lex_advance();
+        /* Groups only affect the parse, so they don't need an expression. */
+        parse_operand_start = frame->first_index;
+        parse_frames_index = parse_frames_index - 1;
+        break;
+      case parse_frame_kind_call:
+        frame->arguments = frame->arguments + 1;
+        if (frame->arguments < frame->arity) {
+          if (lex_kind() != ',') {
+            current_location.index = lex_offset() + 1;
+            parse_log_current_location();
+            log_line("Expected ',' to separate arguments.");
+            parse_log_current_location_line_with_column_marker();
+            syscall_exit(1);
+          }
+          lex_advance();
+          continue;
+        }
+        parse_close_call(frame->name, frame->arity, frame->first_index);
+        parse_frames_index = parse_frames_index - 1;
+        if (parse_frames_index == bottom) {
+          return;
+        }
+        break;
+    }
+    operand_complete = true;
+  }
+}
+
+void parse_expression() {
+  size_t bottom = parse_frames_index;
+  parse_push_frame(parse_frame_kind_expression, 0, 0);
+  parse_expression_frames(bottom, false);
+}
+
+/* Parses the arguments of a call that is used as a statement, after the '('.
+   Nothing can follow the call, so it ends as soon as the ')' is parsed. */
+void parse_call_statement(size_t name_offset, strings_id_t name) {
+  size_t bottom = parse_frames_index;
+  if (!parse_open_call(name_offset, name)) {
+    parse_expression_frames(bottom, false);
+  }
+}
+
+/* --------------------------------------------------------------------------------
+ * CONSTANT EXPRESSIONS
+ *
+ * The values of constants, the lengths of arrays and the values of cases are
+ * expressions that are evaluated while translating, so that the C code only
+ * has their values. They are parsed like any other expression and then
+ * evaluated in one pass over parse_expressions: since expressions are stored
+ * in postfix order, the operands of each expression have all been evaluated
+ * by the time it is reached, so the values can be kept on a stack.
+ * -------------------------------------------------------------------------------- */
+
+/* Values are kept truncated to the width of their type, and signed values are
+   sign extended to 64 bits. Named constants and digits without a suffix are
+   untyped, which is a width of 0, and take the type of the values they are
+   combined with. */
+typedef struct constant_value_t {
+  u64_t value;
+  u8_t width;
+  bool_t is_signed;
+} constant_value_t;
+
+__thread constant_value_t* constant_values;
+
+void constant_error(char const* message) {
+  parse_log_current_location();
+  log_line(message);
+  parse_log_current_location_line_with_column_marker();
+  syscall_exit(1);
+}
+
+constant_value_t constant_convert(u64_t value, u8_t width, bool_t is_signed) {
+  if (width != 0 && width < 64) {
+    u64_t mask = ((u64_t) 1 << width) - 1;
+    value = value & mask;
+    if (is_signed && (value >> (width - 1))) {
+      value = value | ~mask;
+    }
+  }
+  return (constant_value_t) { .value = value, .width = width, .is_signed = is_signed };
+}
+
+/* Converts a value to the given type for a cast, which has to be to one of
+   the integer types. */
+constant_value_t constant_cast(constant_value_t value, type_t type) {
+  u8_t width = 0;
+  if (type.modifier_count == 0) {
+    switch (type.base) {
+      case builtin_strings_i8:
+      case builtin_strings_u8:
+        width = 8;
+        break;
+      case builtin_strings_i16:
+      case builtin_strings_u16:
+        width = 16;
+        break;
+      case builtin_strings_i32:
+      case builtin_strings_u32:
+        width = 32;
+        break;
+      case builtin_strings_i64:
+      case builtin_strings_u64:
+      case builtin_strings_size:
+        width = 64;
+        break;
+    }
+  }
+  if (width == 0) {
+    constant_error("Constant expressions can only be cast to integer types.");
+  }
+  bool_t is_signed = type.base == builtin_strings_i8 || type.base == builtin_strings_i16 || type.base == builtin_strings_i32 || type.base == builtin_strings_i64;
+  return constant_convert(value.value, width, is_signed);
+}
+
+/* Integer literals carry their type as a suffix, such as 10u8. */
+constant_value_t constant_literal(strings_id_t name) {
+  char const* literal = strings_pointers[name];
+  u64_t value = 0;
+  size_t i = 0;
+  while (parse_digit_chars[(u8_t) literal[i]]) {
+    value = value * 10 + (u64_t) (literal[i] - '0');
+    i = i + 1;
+  }
+  if (!literal[i]) {
+    return (constant_value_t) { .value = value, .width = 0, .is_signed = false };
+  }
+  bool_t is_signed = literal[i] == 'i';
+  size_t width = 0;
+  i = i + 1;
+  while (literal[i] && width <= 64) {
+    width = width * 10 + (size_t) (literal[i] - '0');
+    i = i + 1;
+  }
+  if (width != 8 && width != 16 && width != 32 && width != 64) {
+    constant_error("Integer literals in constant expressions have to be 8, 16, 32 or 64 bits wide.");
+  }
+  return constant_convert(value, (u8_t) width, is_signed);
+}
+
+/* Applies a built-in operator to two values of the given type. The result
+   still has to be truncated to the width of the type. */
+u64_t constant_apply(strings_id_t operator, u64_t a, u64_t b, u8_t width, bool_t is_signed) {
+  switch (operator) {
+    case builtin_strings_logical_or: return a != 0 || b != 0;
+    case builtin_strings_logical_and: return a != 0 && b != 0;
+    case builtin_strings_bit_or: return a | b;
+    case builtin_strings_bit_xor: return a ^ b;
+    case builtin_strings_bit_and: return a & b;
+    case builtin_strings_equal: return a == b;
+    case builtin_strings_not_equal: return a != b;
+    case builtin_strings_less: return is_signed ? (i64_t) a < (i64_t) b : a < b;
+    case builtin_strings_less_equal: return is_signed ? (i64_t) a <= (i64_t) b : a <= b;
+    case builtin_strings_greater: return is_signed ? (i64_t) a > (i64_t) b : a > b;
+    case builtin_strings_greater_equal: return is_signed ? (i64_t) a >= (i64_t) b : a >= b;
+    case builtin_strings_plus: return a + b;
+    case builtin_strings_minus: return a - b;
+    case builtin_strings_times: return a * b;
+    case builtin_strings_shift_left:
+    case builtin_strings_shift_right:
+      /* A negative amount is sign extended, so it is too large as well. */
+      if (b >= (width ? width : 64)) {
+        constant_error("Shifts in constant expressions have to be by less than the width of the type.");
+      }
+      if (operator == builtin_strings_shift_left) {
+        return a << b;
+      }
+      return is_signed ? (u64_t) ((i64_t) a >> b) : a >> b;
+    case builtin_strings_divide:
+    case builtin_strings_remainder:
+      if (b == 0) {
+        constant_error("Division by zero in constant expression.");
+      }
+      /* Dividing the most negative value by -1 overflows, so it is done by
+         negating instead, which wraps around. */
+      if (is_signed && (i64_t) b == -1) {
+        return operator == builtin_strings_divide ? 0 - a : 0;
+      }
+      if (operator == builtin_strings_divide) {
+        return is_signed ? (u64_t) ((i64_t) a / (i64_t) b) : a / b;
+      }
+      return is_signed ? (u64_t) ((i64_t) a % (i64_t) b) : a % b;
+    default:
+      parse_log_current_location();
+      log_string("The operator '");
+      log_string(strings_pointers[operator]);
+      log_line("' can't be used in constant expressions.");
+      parse_log_current_location_line_with_column_marker();
+      syscall_exit(1);
+      return 0;
+  }
+}
+
+/* Evaluates the expressions from first up to the end of parse_expressions,
+   which make up a single constant expression. Errors are reported at the
+   current location. */
+u64_t constant_evaluate(size_t first) {
+  size_t count = 0;
+  size_t i = first;
+  while (i < parse_expression_index) {
+    expression_t expression = parse_expressions[i];
+    switch (expression.kind) {
+      case expression_kind_integer:
+        constant_values[count] = constant_literal(expression.data.name);
+        count = count + 1;
+        break;
+      case expression_kind_constant:
+        constant_values[count] = (constant_value_t) { .value = parse_constants[expression.data.name].value, .width = 0, .is_signed = false };
+        count = count + 1;
+        break;
+      case expression_kind_operator:
+        (void) 0;
+        /* The operands take the type of the first one that has a type, and
+           the operators are applied from left to right. */
+        size_t operand = count - expression.arity;
+        u8_t width = 0;
+        bool_t is_signed = false;
+        size_t j = operand;
+        while (j < count && width == 0) {
+          width = constant_values[j].width;
+          is_signed = constant_values[j].is_signed;
+          j = j + 1;
+        }
+        u64_t result = constant_convert(constant_values[operand].value, width, is_signed).value;
+        j = operand + 1;
+        while (j < count) {
+          u64_t next = constant_convert(constant_values[j].value, width, is_signed).value;
+          result = constant_convert(constant_apply(expression.data.name, result, next, width, is_signed), width, is_signed).value;
+          j = j + 1;
+        }
+        constant_values[operand] = (constant_value_t) { .value = result, .width = width, .is_signed = is_signed };
+        count = operand + 1;
+        break;
+      default:
+        /* Casts and ascriptions, since names only refer to constants and
+           there are no calls. */
+        constant_values[count - 1] = constant_cast(constant_values[count - 1], expression.data.type);
+        break;
+    }
+    i = i + 1;
+  }
+  constant_value_t value = constant_values[0];
+  if (value.is_signed && (i64_t) value.value < 0) {
+    constant_error("Constant expressions can't have negative values.");
+  }
+  return value.value;
+}
+
+/* Parses a constant expression and returns its value, leaving the current
+   location right after the expression. It can be nested in other expressions,
+   through the lengths of arrays in casts, so it leaves their state alone. */
+u64_t parse_constant_expression() {
+  size_t start = lex_offset();
+  size_t first = parse_expression_index;
+  size_t operand_start = parse_operand_start;
+  bool_t was_constant_context = parse_constant_context;
+  parse_constant_context = true;
+  parse_expression();
+  parse_constant_context = was_constant_context;
+  parse_operand_start = operand_start;
+  /* The expression ends before any whitespace in front of the next token. */
+  size_t end = lex_offset();
+  while (end > start && parse_whitespace_chars[(u8_t) parse_read_buffer[end - 1]]) {
+    end = end - 1;
+  }
+  current_location.index = start + 1;
+  u64_t value = constant_evaluate(first);
+  parse_expression_index = first;
+  current_location.index = end;
+  return value;
+}
+
+/* -------------------------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------------------
+ * STATEMENTS
+ *
+ * The statements of a function body are collected into an array before any
+ * code is emitted for the function. Blocks are opened by 'if', 'else', 'while',
+ * 'switch' and 'case', and closed by 'end', so the statements themselves are
+ * flat; the nesting is recovered by replaying the openers and closers.
+ * -------------------------------------------------------------------------------- */
+
+/* Describes the most recently parsed declaration, so that it can be emitted.
+   Structs and functions are kept here as well as in the shared tables, since
+   with '-j' the tables may hold an agreeing declaration from another file. */
+__thread declaration_kind_t parse_declaration_kind;
+__thread strings_id_t parse_declaration_name;
+__thread bool_t parse_declaration_has_body;
+__thread struct_info_t parse_declaration_struct;
+__thread parse_fn_signature_t parse_declaration_signature;
+
+/* The fields of the struct being parsed. */
+__thread struct_field_t* parse_fields;
+
+typedef u8_t statement_kind_t;
+#define statement_kind_body 0
+#define statement_kind_if 1
+#define statement_kind_else 2
+#define statement_kind_else_if 3
+#define statement_kind_end 4
+#define statement_kind_switch 5
+#define statement_kind_case 6
+#define statement_kind_while 7
+#define statement_kind_return 8
+#define statement_kind_declare 9
+#define statement_kind_assign 10
+#define statement_kind_call 11
+
+typedef union statement_data_t {
+  /* The type of the variable, for declarations. */
+  type_t type;
+  /* The value being matched against, for cases. */
+  u64_t value;
+} statement_data_t;
+
+typedef struct statement_t {
+  statement_kind_t kind;
+  /* The variable being assigned, for declarations and assignments. */
+  strings_id_t name;
+  /* The index of the statement's expression in parse_expressions, if it has
+     one. */
+  u32_t expression;
+  /* For statements that open a block, the first declaration directly inside
+     the block. For declarations, the next declaration in the same block. The
+     first statement is always the function body, which is not a declaration,
+     so zero means there are no more declarations. */
+  u32_t declarations;
+  statement_data_t data;
+} statement_t;
+
+__thread statement_t* parse_statements;
+__thread size_t parse_statements_index = 0;
+
+typedef struct parse_block_t {
+  /* The statement that opened the block. */
+  u32_t opener;
+  /* The most recent declaration directly inside the block, or zero. */
+  u32_t last_declaration;
+  /* Local variables declared inside the block go out of scope when it
+     closes. */
+  size_t first_local_variable;
+} parse_block_t;
+
+__thread parse_block_t parse_blocks[MAX_BLOCK_DEPTH];
+__thread size_t parse_blocks_index = 0;
+
+size_t parse_add_statement(statement_kind_t kind) {
+  ensure_array_space(parse_statements_index, MAX_STATEMENTS, "parse_statements");
+  size_t index = parse_statements_index;
+  parse_statements[index] = (statement_t) { .kind = kind };
+  parse_statements_index = parse_statements_index + 1;
+  return index;
+}
+
+void parse_open_block(size_t opener) {
+  ensure_array_space(parse_blocks_index, MAX_BLOCK_DEPTH, "parse_blocks");
+  parse_blocks[parse_blocks_index] = (parse_block_t) {
+    .opener = opener,
+    .last_declaration = 0,
+    .first_local_variable = parse_local_variables_index
+  };
+  parse_blocks_index = parse_blocks_index + 1;
+}
+
+void parse_close_block() {
+  parse_blocks_index = parse_blocks_index - 1;
+  parse_remove_local_variables(parse_blocks[parse_blocks_index].first_local_variable);
+}
+
+statement_kind_t parse_innermost_block_kind() {
+  return parse_statements[parse_blocks[parse_blocks_index - 1].opener].kind;
+}
+
+/* Finds the index of the first operand of the expression at the given
+   index. */
+size_t parse_first_operand(size_t index) {
+  size_t operand = index - 1;
+  size_t i = 1;
+  while (i < parse_expressions[index].arity) {
+    operand = operand - parse_expressions[operand].size;
+    i = i + 1;
+  }
+  work_counts[work_steps] = work_counts[work_steps] + i;
+  return operand;
+}
+
+/* Finds the type of the expression rooted at the given index. Operators take
+   the type of their first operand, since all the operands must agree. Constants
+   are untyped, so they are treated as u64. */
+type_t parse_expression_type(size_t index) {
+  while (true) {
+    expression_t expression = parse_expressions[index];
+    switch (expression.kind) {
+      case expression_kind_operation:
+        return parse_find_fn(expression.data.name)->return_type;
+      case expression_kind_operator:
+        index = parse_first_operand(index);
+        break;
+      case expression_kind_integer:
+        (void) 0;
+        char* literal = strings_pointers[expression.data.name];
+        size_t suffix_start = 0;
+        while (parse_digit_chars[(size_t) literal[suffix_start]]) {
+          suffix_start = suffix_start + 1;
+        }
+        size_t suffix_end = suffix_start;
+        while (literal[suffix_end]) {
+          suffix_end = suffix_end + 1;
+        }
+        return (type_t) {
+          .base = strings_id(&literal[suffix_start], suffix_end - suffix_start)
+        };
+      case expression_kind_local:
+        return parse_local_variables[parse_find_local_variable(expression.data.name)].type;
+      case expression_kind_constant:
+        return (type_t) { .base = builtin_strings_u64 };
+      default:
+        return expression.data.type;
+    }
+  }
+}
+
+/* Reports a keyword that is out of place, right after the keyword. */
+void parse_error_unexpected_keyword(size_t end, char const* message) {
+  current_location.index = end;
   parse_log_current_location();
-  log_line("Expected 'struct', 'const', or 'fn' to begin declaration.");
+  log_line(message);
   parse_log_current_location_line_with_column_marker();
   syscall_exit(1);
 }
 
-void parse_error_expected_control_flow_keyword() {
-  parse_log_current_location();
-  log_line("Expected statement.");
-  parse_log_current_location_line_with_column_marker();
-  syscall_exit(1);
+/* Parses statements up to and including the closing brace of a function body.
+   Blocks that are still open at the closing brace are closed implicitly. */
+void parse_fn_body() {
+  parse_forward_calls_count = 0;
+  parse_statements_index = 0;
+  parse_expression_index = 0;
+  parse_blocks_index = 0;
+  parse_open_block(parse_add_statement(statement_kind_body));
+  /* Set when the previous statement was 'else', in which case an 'if'
+     continues the same chain instead of opening a nested block. */
+  bool_t after_else = false;
+  while (true) {
+    token_kind_t next = lex_kind();
+    if (next == token_kind_identifier) {
+      size_t name_offset = lex_offset();
+      strings_id_t name = lex_value();
+      lex_advance();
+      if (name == builtin_strings_if) {
+        parse_expression();
+        if (after_else) {
+          statement_t* chain = &parse_statements[parse_statements_index - 1];
+          chain->kind = statement_kind_else_if;
+          chain->expression = parse_expression_index - 1;
+        } else {
+          size_t statement = parse_add_statement(statement_kind_if);
+          parse_statements[statement].expression = parse_expression_index - 1;
+          parse_open_block(statement);
+        }
+        after_else = false;
+        continue;
+      } else if (name == builtin_strings_else) {
+        statement_kind_t kind = parse_innermost_block_kind();
+        if (kind != statement_kind_if && kind != statement_kind_else_if) {
+          parse_error_unexpected_keyword(name_offset + strings_lengths[name], "Found 'else' without a matching 'if'.");
+        }
+        parse_close_block();
+        parse_open_block(parse_add_statement(statement_kind_else));
+        after_else = true;
+        continue;
+      } else if (name == builtin_strings_end) {
+        if (parse_innermost_block_kind() == statement_kind_case) {
+          parse_close_block();
+        }
+        if (parse_innermost_block_kind() == statement_kind_body) {
+          parse_error_unexpected_keyword(name_offset + strings_lengths[name], "Found 'end' outside of a block.");
+        }
+        parse_close_block();
+        parse_add_statement(statement_kind_end);
+      } else if (name == builtin_strings_switch) {
+        parse_expression();
+        size_t statement = parse_add_statement(statement_kind_switch);
+        parse_statements[statement].expression = parse_expression_index - 1;
+        parse_open_block(statement);
+      } else if (name == builtin_strings_case) {
+        if (parse_innermost_block_kind() == statement_kind_case) {
+          parse_close_block();
+        }
+        if (parse_innermost_block_kind() != statement_kind_switch) {
+          parse_error_unexpected_keyword(name_offset + strings_lengths[name], "Found 'case' outside of a 'switch'.");
+        }
+        u64_t value = parse_constant_expression();
+        parse_skip_whitespace1();
+        size_t statement = parse_add_statement(statement_kind_case);
+        parse_statements[statement].data.value = value;
+        parse_open_block(statement);
+      } else if (name == builtin_strings_while) {
+        parse_expression();
+        size_t statement = parse_add_statement(statement_kind_while);
+        parse_statements[statement].expression = parse_expression_index - 1;
+        parse_open_block(statement);
+      } else if (name == builtin_strings_return) {
+        parse_expression();
+        size_t statement = parse_add_statement(statement_kind_return);
+        parse_statements[statement].expression = parse_expression_index - 1;
+      } else {
+        if (lex_kind() == token_kind_operator && parse_read_buffer[lex_offset()] == '=') {
+          /* The lexer joins the '=' with any operator characters after it,
+             which can't begin an expression. */
+          size_t equals = lex_offset();
+          bool_t joined = strings_lengths[lex_value()] > 1;
+          lex_advance();
+          if (joined) {
+            current_location.index = equals + 2;
+            parse_error_expected_operand();
+          }
+          parse_expression();
+          if (parse_find_local_variable(name) < parse_local_variables_index) {
+            size_t statement = parse_add_statement(statement_kind_assign);
+            parse_statements[statement].name = name;
+            parse_statements[statement].expression = parse_expression_index - 1;
+          } else {
+            type_t type = parse_expression_type(parse_expression_index - 1);
+            size_t statement = parse_add_statement(statement_kind_declare);
+            parse_statements[statement].name = name;
+            parse_statements[statement].expression = parse_expression_index - 1;
+            parse_statements[statement].data.type = type;
+            parse_block_t* block = &parse_blocks[parse_blocks_index - 1];
+            if (block->last_declaration) {
+              parse_statements[block->last_declaration].declarations = statement;
+            } else {
+              parse_statements[block->opener].declarations = statement;
+            }
+            block->last_declaration = statement;
+            parse_add_local_variable((parse_local_variable_t) {
+              .name = name,
+              .type = type
+            });
+          }
+        } else if (lex_kind() == '(') {
+          parse_call_statement(name_offset, name);
+          size_t statement = parse_add_statement(statement_kind_call);
+          parse_statements[statement].expression = parse_expression_index - 1;
+        } else {
+          current_location.index = lex_offset();
+          parse_log_current_location();
+          log_line("Expected statement or '}'.");
+          parse_log_current_location_line_with_column_marker();
+          syscall_exit(1);
+        }
+      }
+      after_else = false;
+    } else if (next == '}') {
+      current_location.index = lex_offset() + 1;
+      return;
+    } else {
+      current_location.index = lex_offset() + 1;
+      parse_log_current_location();
+      log_line("Expected statement or '}'.");
+      parse_log_current_location_line_with_column_marker();
+      syscall_exit(1);
+    }
+  }
+}
+
+/* Parses the keyword that begins a declaration, and the whitespace after it.
+   When it isn't one of the keywords, the characters are matched against them
+   one at a time, so that the error points at the first one that doesn't fit. */
+strings_id_t parse_declaration_keyword() {
+  size_t start = lex_offset();
+  strings_id_t keyword = lex_value();
+  bool_t is_keyword = keyword == builtin_strings_struct || keyword == builtin_strings_const || keyword == builtin_strings_fn;
+  current_location.index = start;
+  if (lex_kind() != token_kind_identifier || !is_keyword) {
+    char c = parse_char();
+    bool_t matches = (c == 's' && parse_exactly("truct")) || (c == 'c' && parse_exactly("onst")) || (c == 'f' && parse_exactly("n"));
+    if (!matches) {
+      parse_error_expected_declaration_start_keyword();
+    }
+  } else {
+    current_location.index = start + strings_lengths[keyword];
+  }
+  parse_skip_whitespace1();
+  lex_advance();
+  return keyword;
+}
+
+void parse_declaration() {
+  /* Only the keyword and the name are lexed at first, since the rest of the
+     header may be skipped. */
+  lex_start(current_location.index, token_kind_end, token_kind_end, 2);
+  strings_id_t keyword = parse_declaration_keyword();
+  if (keyword == builtin_strings_struct) {
+    strings_id_t struct_name = parse_permanent_identifier();
+    parse_declaration_kind = declaration_kind_struct;
+    parse_declaration_name = struct_name;
+    if (parse_skip_prescanned(declaration_kind_struct, struct_name)) {
+      parse_declaration_struct = struct_infos[struct_name];
+      return;
+    }
+    lex_start(lex_resume, ';', ';', LEX_NO_LIMIT);
+    size_t field_count = 0;
+    while (true) {
+      strings_id_t field_name = parse_permanent_identifier();
+      type_t field_type = parse_type();
+      ensure_array_space(field_count, MAX_STRUCT_FIELDS, "struct_fields");
+      parse_fields[field_count] = (struct_field_t) { .name = field_name, .type = field_type };
+      field_count = field_count + 1;
+      token_kind_t separator = lex_kind();
+      current_location.index = lex_offset() + 1;
+      if (separator == ',') {
+        lex_advance();
+      } else if (separator == ';') {
+        parse_declaration_struct = (struct_info_t) {
+          .field_count = field_count,
+          .first_field_index = parse_add_struct_fields(parse_fields, field_count),
+          .exists = true
+        };
+        parse_declare_struct(struct_name, parse_declaration_struct);
+        return;
+      } else {
+        parse_log_current_location();
+        log_line("Expected ',' or ';'.");
+        parse_log_current_location_line_with_column_marker();
+        syscall_exit(1);
+      }
+    }
+  } else if (keyword == builtin_strings_const) {
+    strings_id_t const_name = parse_permanent_identifier();
+    parse_declaration_kind = declaration_kind_const;
+    parse_declaration_name = const_name;
+    if (parse_skip_prescanned(declaration_kind_const, const_name)) {
+      return;
+    }
+    /* The value is an expression, which ends with the line. */
+    lex_start(lex_resume, '\n', '\n', LEX_NO_LIMIT);
+    if (lex_kind() != token_kind_operator || parse_read_buffer[lex_offset()] != '=') {
+      current_location.index = lex_offset() + 1;
+      parse_log_current_location();
+      log_line("Expected '='.");
+      parse_log_current_location_line_with_column_marker();
+      syscall_exit(1);
+    }
+    /* The lexer joins the '=' with any operator characters after it, which
+       can't begin a constant. */
+    size_t equals = lex_offset();
+    bool_t joined = strings_lengths[lex_value()] > 1;
+    lex_advance();
+    if (joined) {
+      current_location.index = equals + 1;
+      parse_error_expected_integer_constant();
+    }
+    u64_t const_value = parse_constant_expression();
+    parse_skip_whitespace1();
+    parse_declare_constant(const_name, const_value);
+  } else {
+    strings_id_t fn_name = parse_permanent_identifier();
+    /* Bodies are skipped while prescanning, so only the header is lexed. */
+    token_kind_t header_end = parse_prescanning ? '{' : '}';
+    parse_fn_signature_t signature;
+    if (parse_skip_prescanned(declaration_kind_fn, fn_name)) {
+      lex_start(current_location.index, '.', header_end, LEX_NO_LIMIT);
+      signature = *parse_find_fn(fn_name);
+      parse_remove_local_variables(0);
+      u16_t i = 0;
+      while (i < signature.arity) {
+        parse_add_local_variable(parse_fn_arguments[signature.first_argument + i]);
+        i = i + 1;
+      }
+    } else {
+      lex_start(lex_resume, '.', header_end, LEX_NO_LIMIT);
+      if (lex_kind() != '(') {
+        current_location.index = lex_offset() + 1;
+        parse_log_current_location();
+        log_line("Expected '(' to begin argument list.");
+        parse_log_current_location_line_with_column_marker();
+        syscall_exit(1);
+      }
+      size_t parenthesis = lex_offset();
+      lex_advance();
+      signature = (parse_fn_signature_t) {0};
+      parse_remove_local_variables(0);
+      /* The first argument, or the ')', has to come right after the '('. */
+      if (lex_spaced()) {
+        current_location.index = parenthesis + 2;
+        parse_error_expected_identifier();
+      }
+      if (lex_kind() != ')') {
+        while (true) {
+          if (signature.arity == MAX_ARITY) {
+            current_location.index = lex_offset() + 1;
+            parse_log_current_location();
+            log_line("Functions can't have more than 255 arguments.");
+            parse_log_current_location_line_with_column_marker();
+            syscall_exit(1);
+          }
+          parse_local_variable_t variable = {0};
+          variable.name = parse_permanent_identifier();
+          variable.type = parse_type();
+          parse_add_local_variable(variable);
+          signature.arity = signature.arity + 1;
+          token_kind_t separator = lex_kind();
+          if (separator == ',') {
+            lex_advance();
+          } else if (separator == ')') {
+            break;
+          } else {
+            current_location.index = lex_offset() + 1;
+            parse_log_current_location();
+            log_line("Expected ',' or ')'.");
+            parse_log_current_location_line_with_column_marker();
+            syscall_exit(1);
+          }
+        }
+      }
+      lex_advance();
+      if (lex_kind() == '`') {
+        signature.return_type = parse_type();
+      } else {
+        signature.return_type.base = builtin_strings_void;
+      }
+      /* The arguments are the only local variables so far. */
+      signature.first_argument = parse_add_fn_arguments(parse_local_variables, signature.arity);
+      current_location.index = lex_offset();
+      parse_declare_fn(fn_name, &signature);
+    }
+    parse_declaration_signature = signature;
+    token_kind_t c = lex_kind();
+    parse_declaration_kind = declaration_kind_fn;
+    parse_declaration_name = fn_name;
+    parse_declaration_has_body = c == '{';
+    if (c == '{' && parse_prescanning) {
+      /* Bodies can't contain '}', so there is no need to parse them to
+         find where they end. */
+      current_location.index = scan_find(parse_read_buffer, lex_offset(), parse_read_buffer_length, '}', '}') + 1;
+    } else if (c == '{') {
+      lex_advance();
+      parse_fn_body();
+    } else if (c == '.') {
+      /* We already saved the function signature, so there is nothing else to
+         do except move past the dot. */
+      current_location.index = lex_offset() + 1;
+    } else {
+      current_location.index = lex_offset();
+      parse_log_current_location();
+      log_line("Expected '.' or '{' after argument list.");
+      parse_log_current_location_line_with_column_marker();
+      syscall_exit(1);
+    }
+  }
+}
+
+/* --------------------------------------------------------------------------------
+ * EMITTING
+ *
+ * The translated C code is accumulated in a large buffer, which is only
+ * written out when it fills up and once more at the very end. This keeps the
+ * number of system calls proportional to the number of megabytes of output
+ * rather than the number of lines.
+ * -------------------------------------------------------------------------------- */
+
+__thread char* emit_buffer;
+__thread size_t emit_buffer_length = 0;
+__thread size_t emit_buffer_capacity = 0;
+i32_t emit_fd = 1;
+__thread size_t emit_indent_count = 0;
+
+/* While capturing, everything emitted from emit_capture_start onwards is also
+   saved to the cache before the buffer is written out. */
+void cache_put(void const* data, size_t length);
+bool_t emit_capturing = false;
+size_t emit_capture_start = 0;
+
+void emit_write(char const* data, size_t length) {
+  measure_phase_t previous_phase = measure_switch(measure_phase_emit);
+  size_t written = 0;
+  while (written < length) {
+    i64_t result = syscall_write(emit_fd, &data[written], length - written);
+    if (result <= 0) {
+      log_line("Got unix error code while writing output.");
+      syscall_exit(1);
+    }
+    written = written + result;
+  }
+  measure_switch(previous_phase);
+}
+
+void emit_flush() {
+  if (emit_capturing) {
+    cache_put(&emit_buffer[emit_capture_start], emit_buffer_length - emit_capture_start);
+    emit_capture_start = 0;
+  }
+  emit_write(emit_buffer, emit_buffer_length);
+  emit_buffer_length = 0;
+}
+
+/* Allocates an empty buffer, which is written out whenever it is full.
+   Threads for '-j' keep the whole output of a chunk in memory, so their buffer
+   grows instead. */
+void emit_start_buffer() {
+  emit_buffer = memory_allocate(EMIT_BUFFER_CAPACITY);
+  emit_buffer_length = 0;
+  emit_buffer_capacity = EMIT_BUFFER_CAPACITY;
+}
+
+void emit_make_room() {
+  if (!threads_chunk) {
+    emit_flush();
+    return;
+  }
+  void* grown = syscall_mremap(emit_buffer, emit_buffer_capacity, 2 * emit_buffer_capacity, MREMAP_MAYMOVE);
+  if (syscall_mmap_failed(grown)) {
+    log_line("Got unix error code while allocating memory.");
+    syscall_exit(1);
+  }
+  emit_buffer = grown;
+  emit_buffer_capacity = 2 * emit_buffer_capacity;
+}
+
+void emit_char(char c) {
+  if (emit_buffer_length == emit_buffer_capacity) {
+    emit_make_room();
+  }
+  emit_buffer[emit_buffer_length] = c;
+  emit_buffer_length = emit_buffer_length + 1;
+}
+
+void emit_lstring(char const* s, size_t length) {
+  while (length > 0) {
+    if (emit_buffer_length == emit_buffer_capacity) {
+      emit_make_room();
+    }
+    size_t chunk = min_size(length, emit_buffer_capacity - emit_buffer_length);
+    copy_bytes(&emit_buffer[emit_buffer_length], s, chunk);
+    emit_buffer_length = emit_buffer_length + chunk;
+    s = s + chunk;
+    length = length - chunk;
+  }
+}
+
+void emit_string(char const* s) {
+  size_t length = 0;
+  while (s[length]) {
+    length = length + 1;
+  }
+  emit_lstring(s, length);
+}
+
+void emit_name(strings_id_t name) {
+  emit_lstring(strings_pointers[name], strings_lengths[name]);
+}
+
+void emit_u64(u64_t x) {
+  u64_t magnitude = 1;
+  while (x / magnitude >= 10) {
+    magnitude = magnitude * 10;
+  }
+  while (magnitude > 0) {
+    emit_char((char) (x / magnitude) + '0');
+    x = x % magnitude;
+    magnitude = magnitude / 10;
+  }
+}
+
+char const EMIT_SPACES[32] = "                                ";
+
+void emit_start_line() {
+  size_t remaining = emit_indent_count;
+  while (remaining > 0) {
+    size_t chunk = min_size(remaining, sizeof(EMIT_SPACES));
+    emit_lstring(EMIT_SPACES, chunk);
+    remaining = remaining - chunk;
+  }
+}
+
+void emit_indent() {
+  emit_indent_count = emit_indent_count + 2;
+}
+
+void emit_dedent() {
+  emit_indent_count = emit_indent_count - 2;
+}
+
+void emit_preamble() {
+  emit_string("typedef signed char i8;\n");
+  emit_string("typedef unsigned char u8;\n");
+  emit_string("typedef signed short i16;\n");
+  emit_string("typedef unsigned short u16;\n");
+  emit_string("typedef signed int i32;\n");
+  emit_string("typedef unsigned int u32;\n");
+  emit_string("typedef signed long i64;\n");
+  emit_string("typedef unsigned long u64;\n");
+  emit_string("typedef unsigned long size;\n");
+  emit_string("typedef float f32;\n");
+  emit_string("typedef double f64;\n");
+}
+
+bool_t type_modifier_is_array(type_t type, size_t modifier) {
+  return (type.modifiers >> modifier) & 1;
+}
+
+/* A C declarator wraps around the declared name, so types are emitted in two
+   halves. The prefix is the base type followed by any pointers, and the suffix
+   holds the array lengths. Modifiers closest to the base type end up furthest
+   from the name, and a pointer to an array needs parentheses so that it is not
+   read as an array of pointers. When there is no name, as in a cast, the
+   result is an abstract declarator. */
+void emit_type_prefix(type_t type, bool_t has_name) {
+  emit_name(type.base);
+  size_t i = 0;
+  while (i < type.modifier_count && !type_modifier_is_array(type, i)) {
+    emit_char('*');
+    i = i + 1;
+  }
+  if (has_name || i < type.modifier_count) {
+    emit_char(' ');
+  }
+  while (i < type.modifier_count) {
+    if (!type_modifier_is_array(type, i)) {
+      emit_char('*');
+    } else if (i + 1 < type.modifier_count && !type_modifier_is_array(type, i + 1)) {
+      emit_char('(');
+    }
+    i = i + 1;
+  }
+}
+
+void emit_type_suffix(type_t type) {
+  size_t array_length_index = type.first_array_length_index;
+  size_t i = 0;
+  while (i < type.modifier_count) {
+    array_length_index = array_length_index + type_modifier_is_array(type, i);
+    i = i + 1;
+  }
+  while (i > 0) {
+    i = i - 1;
+    if (type_modifier_is_array(type, i)) {
+      array_length_index = array_length_index - 1;
+      if (i + 1 < type.modifier_count && !type_modifier_is_array(type, i + 1)) {
+        emit_char(')');
+      }
+      emit_char('[');
+      emit_u64(array_lengths[array_length_index]);
+      emit_char(']');
+    }
+  }
+}
+
+/* Constants are untyped, so they are emitted with a suffix only when they do
+   not fit in an int. */
+void emit_constant(u64_t value) {
+  emit_u64(value);
+  if (value > 0x7fffffff) {
+    emit_string("ul");
+  }
+}
+
+/* Integer literals carry their type as a suffix, such as 10u8, which becomes a
+   cast. Leading zeros are dropped so that C does not read the digits as
+   octal. */
+void emit_integer_literal(strings_id_t name) {
+  char* literal = strings_pointers[name];
+  size_t suffix_start = 0;
+  while (parse_digit_chars[(size_t) literal[suffix_start]]) {
+    suffix_start = suffix_start + 1;
+  }
+  char* suffix = &literal[suffix_start];
+  emit_char('(');
+  emit_string(suffix);
+  emit_char(')');
+  size_t i = 0;
+  while (i + 1 < suffix_start && literal[i] == '0') {
+    i = i + 1;
+  }
+  while (i < suffix_start) {
+    emit_char(literal[i]);
+    i = i + 1;
+  }
+  if (string_equal("u64", suffix)) {
+    emit_string("ul");
+  } else if (string_equal("i64", suffix)) {
+    emit_string("l");
+  }
+}
+
+/* Expressions are emitted with an explicit stack of pending work rather than
+   by recursion, so deeply nested expressions cannot overflow the C stack. Each
+   item either emits a whole subtree, or emits the text that goes between or
+   after the operands of an expression. */
+typedef u8_t emit_step_t;
+#define emit_step_expression 0
+#define emit_step_separator 1
+#define emit_step_close 2
+
+typedef struct emit_work_t {
+  emit_step_t step;
+  /* Set when an operator expression has to be wrapped in parentheses, because
+     it is the operand of another operator or of a cast. */
+  bool_t parenthesize;
+  u32_t expression;
+} emit_work_t;
+
+__thread emit_work_t* emit_work;
+__thread size_t emit_work_index = 0;
+
+void emit_push_work(emit_step_t step, bool_t parenthesize, size_t expression) {
+  ensure_array_space(emit_work_index, limit_expressions, "emit_work");
+  emit_work[emit_work_index] = (emit_work_t) { .step = step, .parenthesize = parenthesize, .expression = expression };
+  emit_work_index = emit_work_index + 1;
+  work_counts[work_steps] = work_counts[work_steps] + 1;
+}
+
+/* Schedules the operands of an expression, with a separator between each pair.
+   The operands are found from last to first, which is the order they need to
+   be pushed in to be emitted from first to last. Groups are not kept by the
+   parser, so any operator that is nested in something other than a call is
+   parenthesized to preserve the parse. */
+void emit_push_operands(size_t index) {
+  bool_t parenthesize = parse_expressions[index].kind != expression_kind_operation;
+  size_t operand = index - 1;
+  size_t i = 0;
+  while (i < parse_expressions[index].arity) {
+    if (i > 0) {
+      emit_push_work(emit_step_separator, false, index);
+    }
+    emit_push_work(emit_step_expression, parenthesize, operand);
+    operand = operand - parse_expressions[operand].size;
+    i = i + 1;
+  }
+}
+
+void emit_expression(size_t root) {
+  emit_work_index = 0;
+  emit_push_work(emit_step_expression, false, root);
+  while (emit_work_index > 0) {
+    emit_work_index = emit_work_index - 1;
+    emit_work_t work = emit_work[emit_work_index];
+    expression_t expression = parse_expressions[work.expression];
+    if (work.step == emit_step_separator) {
+      if (expression.kind == expression_kind_operation) {
+        emit_string(", ");
+      } else {
+        emit_char(' ');
+        emit_name(expression.data.name);
+        emit_char(' ');
+      }
+      continue;
+    } else if (work.step == emit_step_close) {
+      emit_char(')');
+      continue;
+    }
+    switch (expression.kind) {
+      case expression_kind_operation:
+        emit_name(expression.data.name);
+        emit_char('(');
+        emit_push_work(emit_step_close, false, work.expression);
+        emit_push_operands(work.expression);
+        break;
+      case expression_kind_operator:
+        if (work.parenthesize) {
+          emit_char('(');
+          emit_push_work(emit_step_close, false, work.expression);
+        }
+        emit_push_operands(work.expression);
+        break;
+      case expression_kind_integer:
+        emit_integer_literal(expression.data.name);
+        break;
+      case expression_kind_local:
+        emit_name(expression.data.name);
+        break;
+      case expression_kind_constant:
+        emit_constant(parse_constants[expression.data.name].value);
+        break;
+      case expression_kind_cast:
+        emit_char('(');
+        emit_type_prefix(expression.data.type, false);
+        emit_type_suffix(expression.data.type);
+        emit_char(')');
+        emit_push_operands(work.expression);
+        break;
+      case expression_kind_ascription:
+        /* Ascriptions only check the type, so there is nothing to emit. */
+        emit_push_operands(work.expression);
+        break;
+    }
+  }
+}
+
+__thread statement_kind_t emit_block_kinds[MAX_BLOCK_DEPTH];
+__thread size_t emit_blocks_index = 0;
+
+/* Opens the block belonging to the given statement, declaring all the local
+   variables that are declared directly inside it. C89 only allows
+   declarations at the start of a block. */
+void emit_open_block(size_t opener) {
+  emit_char('{');
+  emit_char('\n');
+  emit_indent();
+  emit_block_kinds[emit_blocks_index] = parse_statements[opener].kind;
+  emit_blocks_index = emit_blocks_index + 1;
+  size_t declaration = parse_statements[opener].declarations;
+  while (declaration) {
+    statement_t statement = parse_statements[declaration];
+    emit_start_line();
+    emit_type_prefix(statement.data.type, true);
+    emit_name(statement.name);
+    emit_type_suffix(statement.data.type);
+    emit_string(";\n");
+    declaration = statement.declarations;
+  }
+}
+
+void emit_close_block() {
+  emit_blocks_index = emit_blocks_index - 1;
+  emit_dedent();
+  emit_start_line();
+  emit_char('}');
+  if (emit_block_kinds[emit_blocks_index] == statement_kind_case) {
+    emit_string(" break;");
+  }
+  emit_char('\n');
+}
+
+void emit_fn_signature(strings_id_t name, parse_fn_signature_t const* signature) {
+  emit_type_prefix(signature->return_type, true);
+  emit_name(name);
+  emit_char('(');
+  if (signature->arity == 0) {
+    emit_string("void");
+  }
+  size_t i = 0;
+  while (i < signature->arity) {
+    if (i > 0) {
+      emit_string(", ");
+    }
+    parse_local_variable_t argument = parse_fn_arguments[signature->first_argument + i];
+    emit_type_prefix(argument.type, true);
+    emit_name(argument.name);
+    emit_type_suffix(argument.type);
+    i = i + 1;
+  }
+  emit_char(')');
+  emit_type_suffix(signature->return_type);
+}
+
+void emit_fn_body() {
+  emit_blocks_index = 0;
+  emit_open_block(0);
+  size_t i = 1;
+  while (i < parse_statements_index) {
+    statement_t statement = parse_statements[i];
+    switch (statement.kind) {
+      case statement_kind_if:
+        emit_start_line();
+        emit_string("if (");
+        emit_expression(statement.expression);
+        emit_string(") ");
+        emit_open_block(i);
+        break;
+      case statement_kind_else:
+      case statement_kind_else_if:
+        emit_blocks_index = emit_blocks_index - 1;
+        emit_dedent();
+        emit_start_line();
+        emit_string("} else ");
+        if (statement.kind == statement_kind_else_if) {
+          emit_string("if (");
+          emit_expression(statement.expression);
+          emit_string(") ");
+        }
+        emit_open_block(i);
+        break;
+      case statement_kind_end:
+        if (emit_block_kinds[emit_blocks_index - 1] == statement_kind_case) {
+          emit_close_block();
+        }
+        emit_close_block();
+        break;
+      case statement_kind_switch:
+        emit_start_line();
+        emit_string("switch (");
+        emit_expression(statement.expression);
+        emit_string(") ");
+        emit_open_block(i);
+        break;
+      case statement_kind_case:
+        if (emit_block_kinds[emit_blocks_index - 1] == statement_kind_case) {
+          emit_close_block();
+        }
+        emit_start_line();
+        emit_string("case ");
+        emit_constant(statement.data.value);
+        emit_string(": ");
+        emit_open_block(i);
+        break;
+      case statement_kind_while:
+        emit_start_line();
+        emit_string("while (");
+        emit_expression(statement.expression);
+        emit_string(") ");
+        emit_open_block(i);
+        break;
+      case statement_kind_return:
+        emit_start_line();
+        emit_string("return ");
+        emit_expression(statement.expression);
+        emit_string(";\n");
+        break;
+      case statement_kind_declare:
+      case statement_kind_assign:
+        emit_start_line();
+        emit_name(statement.name);
+        emit_string(" = ");
+        emit_expression(statement.expression);
+        emit_string(";\n");
+        break;
+      case statement_kind_call:
+        emit_start_line();
+        emit_expression(statement.expression);
+        emit_string(";\n");
+        break;
+    }
+    i = i + 1;
+  }
+  while (emit_blocks_index > 0) {
+    emit_close_block();
+  }
+}
+
+/* Emits prototypes for the functions that the most recently parsed function
+   calls before they are declared. */
+void emit_forward_prototypes() {
+  size_t i = 0;
+  while (i < parse_forward_calls_count) {
+    strings_id_t name = parse_forward_calls[i];
+    emit_char('\n');
+    emit_fn_signature(name, parse_find_fn(name));
+    emit_string(";\n");
+    i = i + 1;
+  }
+  parse_forward_calls_count = 0;
+}
+
+/* Emits the most recently parsed declaration. Constants are substituted at
+   each use, so they produce no code of their own. */
+void emit_declaration() {
+  measure_phase_t previous_phase = measure_switch(measure_phase_emit);
+  emit_forward_prototypes();
+  strings_id_t name = parse_declaration_name;
+  if (parse_declaration_kind == declaration_kind_struct) {
+    struct_info_t info = parse_declaration_struct;
+    emit_char('\n');
+    emit_string("typedef struct ");
+    emit_name(name);
+    emit_char(' ');
+    emit_name(name);
+    emit_string(";\n");
+    emit_string("struct ");
+    emit_name(name);
+    emit_string(" {\n");
+    size_t i = 0;
+    while (i < info.field_count) {
+      struct_field_t field = struct_fields[info.first_field_index + i];
+      emit_string("  ");
+      emit_type_prefix(field.type, true);
+      emit_name(field.name);
+      emit_type_suffix(field.type);
+      emit_string(";\n");
+      i = i + 1;
+    }
+    emit_string("};\n");
+  } else if (parse_declaration_kind == declaration_kind_fn) {
+    emit_char('\n');
+    emit_fn_signature(name, &parse_declaration_signature);
+    if (parse_declaration_has_body) {
+      emit_char(' ');
+      emit_fn_body();
+    } else {
+      emit_string(";\n");
+    }
+  }
+  measure_switch(previous_phase);
+}
+
+/* -------------------------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------------------
+ * CACHE
+ *
+ * Finding where a function ends and hashing its bytes is far cheaper than
+ * translating it, so the translation of each function can be saved to a cache
+ * file and reused by a later run in which the function is unchanged. Besides
+ * its own bytes, the translation of a function depends on the signatures of
+ * the functions it calls and on the values of the constants it uses, so the
+ * cache also keeps a hash of each of those, and an entry is only reused if
+ * they all still match. Structs and constants are cheap to parse, so they are
+ * always parsed.
+ *
+ * The file starts with CACHE_MAGIC and CACHE_VERSION, followed by entries laid
+ * out like this, with integers in native byte order and strings stored as a
+ * u32 length followed by the bytes:
+ *
+ *   u32  length of the whole entry in bytes
+ *   u64  hash of the bytes of the declaration
+ *   u64  length of the declaration in bytes, followed by the bytes, which are
+ *        compared as well so that a hash collision can't reuse an entry
+ *   u32  number of dependencies, each of which is a u8 kind, a string name,
+ *        and a u64 hash of the record the name had
+ *   the name of the function, and its signature record
+ *   u32  length of the emitted C code, followed by the code
+ *
+ * The version must change whenever the records or the emitted code change.
+ *
+ * New entries are appended to the file, so a run in which nothing changed
+ * writes nothing. Entries that were not used by a run are garbage, and once
+ * they outnumber the used ones, the file is rewritten with only the used ones.
+ * -------------------------------------------------------------------------------- */
+
+char const CACHE_MAGIC[8] = "MINCACHE";
+#define CACHE_VERSION 2
+
+const u64_t FNV64_OFFSET_BASIS = 0xcbf29ce484222325ul;
+const u64_t FNV64_PRIME = 0x100000001b3ul;
+
+u64_t cache_hash_bytes(u64_t hash, u8_t const* data, size_t length) {
+  size_t i = 0;
+  while (i < length) {
+    hash = hash ^ data[i];
+    hash = hash * FNV64_PRIME;
+    i = i + 1;
+  }
+  return hash;
+}
+
+bool_t cache_enabled = false;
+char const* cache_filename = 0;
+char cache_temporary_filename[MAX_FILENAME_LENGTH];
+
+/* New entries are written through this buffer. Entries are never split across
+   flushes, so that their lengths can be filled in once they are complete. It
+   is allocated when the cache or an interface file is opened. */
+char* cache_buffer = 0;
+size_t cache_buffer_length = 0;
+i32_t cache_fd = -1;
+size_t cache_entry_start = 0;
+/* Set when the current entry does not fit in the buffer, in which case the
+   entry is dropped. */
+bool_t cache_overflowed = false;
+
+/* While hashing, everything that would be written is hashed instead. This
+   lets records be hashed in exactly the form they are stored in. */
+bool_t cache_hashing = false;
+u64_t cache_hash_state = 0;
+
+void cache_write(void const* data, size_t length) {
+  size_t written = 0;
+  while (written < length) {
+    i64_t result = syscall_write(cache_fd, (u8_t const*) data + written, length - written);
+    if (result <= 0) {
+      log_line("Got unix error code while writing the cache.");
+      syscall_exit(1);
+    }
+    written = written + result;
+  }
+}
+
+/* The number of bytes written to the file so far. */
+size_t cache_flushed_length = 0;
+
+void cache_flush() {
+  cache_write(cache_buffer, cache_buffer_length);
+  cache_flushed_length = cache_flushed_length + cache_buffer_length;
+  cache_buffer_length = 0;
+}
+
+void cache_put(void const* data, size_t length) {
+  if (cache_hashing) {
+    cache_hash_state = cache_hash_bytes(cache_hash_state, data, length);
+  } else if (cache_overflowed || length > CACHE_BUFFER_CAPACITY - cache_buffer_length) {
+    cache_overflowed = true;
+  } else {
+    copy_bytes(&cache_buffer[cache_buffer_length], data, length);
+    cache_buffer_length = cache_buffer_length + length;
+  }
+}
+
+void cache_put_u8(u8_t value) {
+  cache_put(&value, sizeof(value));
+}
+
+void cache_put_u16(u16_t value) {
+  cache_put(&value, sizeof(value));
+}
+
+void cache_put_u32(u32_t value) {
+  cache_put(&value, sizeof(value));
+}
+
+void cache_put_u64(u64_t value) {
+  cache_put(&value, sizeof(value));
+}
+
+/* Strings are normally stored inline. When cache_strings_indexed is set, they
+   are stored as indexes into a table instead, which is how interface files
+   store them. When writing, cache_string_table lists the ids in the table and
+   cache_string_table_indexes maps ids to their index plus one, or 0 if the
+   string is not in the table yet. When reading, cache_string_ids maps indexes
+   to ids. */
+__thread bool_t cache_strings_indexed = false;
+strings_id_t* cache_string_table = 0;
+u32_t cache_string_table_count = 0;
+u32_t* cache_string_table_indexes = 0;
+__thread strings_id_t* cache_string_ids;
+__thread u32_t cache_string_ids_count = 0;
+
+void cache_put_string(strings_id_t id) {
+  if (cache_strings_indexed) {
+    if (!cache_string_table_indexes[id]) {
+      cache_string_table[cache_string_table_count] = id;
+      cache_string_table_count = cache_string_table_count + 1;
+      cache_string_table_indexes[id] = cache_string_table_count;
+    }
+    cache_put_u32(cache_string_table_indexes[id] - 1);
+  } else {
+    cache_put_u32(strings_lengths[id]);
+    cache_put(strings_pointers[id], strings_lengths[id]);
+  }
+}
+
+/* Array lengths are stored inline, since indexes into array_lengths are only
+   meaningful within one run. */
+void cache_put_type(type_t type) {
+  cache_put_string(type.base);
+  cache_put_u8(type.modifier_count);
+  cache_put_u8(type.modifiers);
+  size_t array_length_index = type.first_array_length_index;
+  u8_t i = 0;
+  while (i < type.modifier_count) {
+    if (type.modifiers & (1 << i)) {
+      cache_put_u64(array_lengths[array_length_index]);
+      array_length_index = array_length_index + 1;
+    }
+    i = i + 1;
+  }
+}
+
+void cache_put_fn_signature(parse_fn_signature_t const* signature) {
+  cache_put_u16(signature->arity);
+  u16_t i = 0;
+  while (i < signature->arity) {
+    parse_local_variable_t argument = parse_fn_arguments[signature->first_argument + i];
+    cache_put_string(argument.name);
+    cache_put_type(argument.type);
+    i = i + 1;
+  }
+  cache_put_type(signature->return_type);
+}
+
+/* Records are read from a mapped file. Reads past the end of the record being
+   read set cache_read_failed instead of reading out of bounds, so a damaged
+   cache can only cause entries to be ignored. */
+__thread u8_t const* cache_read_data = 0;
+__thread size_t cache_read_index = 0;
+__thread size_t cache_read_end = 0;
+__thread bool_t cache_read_failed = false;
+
+void cache_get(void* data, size_t length) {
+  if (cache_read_failed || length > cache_read_end - cache_read_index) {
+    cache_read_failed = true;
+    u8_t* bytes = data;
+    size_t i = 0;
+    while (i < length) {
+      bytes[i] = 0;
+      i = i + 1;
+    }
+  } else {
+    copy_bytes(data, &cache_read_data[cache_read_index], length);
+    cache_read_index = cache_read_index + length;
+  }
+}
+
+/* Reads the given number of bytes and returns whether they equal the given
+   data. */
+bool_t cache_get_matches(char const* data, size_t length) {
+  if (cache_read_failed || length > cache_read_end - cache_read_index) {
+    cache_read_failed = true;
+    return false;
+  }
+  size_t index = cache_read_index;
+  cache_read_index = cache_read_index + length;
+  return strings_equal_bytes((char const*) &cache_read_data[index], data, length);
+}
+
+u8_t cache_get_u8() {
+  u8_t value;
+  cache_get(&value, sizeof(value));
+  return value;
+}
+
+u16_t cache_get_u16() {
+  u16_t value;
+  cache_get(&value, sizeof(value));
+  return value;
+}
+
+u32_t cache_get_u32() {
+  u32_t value;
+  cache_get(&value, sizeof(value));
+  return value;
+}
+
+u64_t cache_get_u64() {
+  u64_t value;
+  cache_get(&value, sizeof(value));
+  return value;
+}
+
+strings_id_t cache_get_string() {
+  if (cache_strings_indexed) {
+    u32_t index = cache_get_u32();
+    if (index >= cache_string_ids_count) {
+      cache_read_failed = true;
+      return 0;
+    }
+    return cache_string_ids[index];
+  }
+  u32_t length = cache_get_u32();
+  if (cache_read_failed || length > cache_read_end - cache_read_index) {
+    cache_read_failed = true;
+    return 0;
+  }
+  strings_id_t id = strings_id((char const*) &cache_read_data[cache_read_index], length);
+  cache_read_index = cache_read_index + length;
+  return id;
+}
+
+type_t cache_get_type() {
+  type_t type = {
+    .base = cache_get_string(),
+    .modifier_count = cache_get_u8(),
+    .modifiers = cache_get_u8()
+  };
+  if (type.modifier_count > MAX_TYPE_MODIFIERS) {
+    cache_read_failed = true;
+    return type;
+  }
+  u64_t lengths[MAX_TYPE_MODIFIERS];
+  size_t length_count = 0;
+  u8_t i = 0;
+  while (i < type.modifier_count) {
+    if (type.modifiers & (1 << i)) {
+      lengths[length_count] = cache_get_u64();
+      length_count = length_count + 1;
+    }
+    i = i + 1;
+  }
+  type.first_array_length_index = parse_add_array_lengths(lengths, length_count);
+  return type;
+}
+
+parse_fn_signature_t cache_get_fn_signature() {
+  parse_fn_signature_t signature = {0};
+  u16_t arity = cache_get_u16();
+  if (arity > MAX_ARITY) {
+    cache_read_failed = true;
+    return signature;
+  }
+  signature.arity = arity;
+  signature.first_argument = parse_reserve_fn_arguments(arity);
+  u16_t i = 0;
+  while (i < arity) {
+    parse_local_variable_t* argument = &parse_fn_arguments[signature.first_argument + i];
+    argument->name = cache_get_string();
+    argument->type = cache_get_type();
+    i = i + 1;
+  }
+  signature.return_type = cache_get_type();
+  return signature;
+}
+
+typedef u8_t cache_dependency_kind_t;
+#define cache_dependency_kind_fn 0
+#define cache_dependency_kind_constant 1
+
+typedef struct cache_dependency_t {
+  cache_dependency_kind_t kind;
+  strings_id_t name;
+} cache_dependency_t;
+
+/* The dependencies of the function being parsed. Each name is only recorded
+   once per declaration, which the marks keep track of by storing the serial
+   number of the declaration that last recorded it. */
+cache_dependency_t* cache_dependencies = 0;
+size_t cache_dependencies_count = 0;
+u32_t* cache_dependency_marks[2] = { 0 };
+u32_t cache_declaration_serial = 0;
+bool_t cache_recording = false;
+
+void cache_depend_on(cache_dependency_kind_t kind, strings_id_t name) {
+  if (!cache_recording || cache_dependency_marks[kind][name] == cache_declaration_serial) {
+    return;
+  }
+  /* A recursive call depends on the function's own signature, which comes
+     from the same bytes as its body. */
+  if (kind == cache_dependency_kind_fn && name == parse_declaration_name) {
+    return;
+  }
+  cache_dependency_marks[kind][name] = cache_declaration_serial;
+  cache_dependencies[cache_dependencies_count] = (cache_dependency_t) { .kind = kind, .name = name };
+  cache_dependencies_count = cache_dependencies_count + 1;
+}
+
+void cache_depend_on_fn(strings_id_t name) {
+  cache_depend_on(cache_dependency_kind_fn, name);
+}
+
+void cache_depend_on_constant(strings_id_t name) {
+  cache_depend_on(cache_dependency_kind_constant, name);
+}
+
+/* Hashes the current record of a dependency, including whether it exists. */
+u64_t cache_dependency_hash(cache_dependency_kind_t kind, strings_id_t name) {
+  cache_hashing = true;
+  cache_hash_state = FNV64_OFFSET_BASIS;
+  if (kind == cache_dependency_kind_fn) {
+    parse_fn_signature_t const* signature = parse_find_fn(name);
+    cache_put_u8(signature != 0);
+    if (signature) {
+      cache_put_fn_signature(signature);
+    }
+  } else {
+    parse_constant_t constant = parse_constants[name];
+    cache_put_u8(constant.exists);
+    cache_put_u64(constant.value);
+  }
+  cache_hashing = false;
+  return cache_hash_state;
+}
+
+/* The entries of the cache from the previous run. Each slot is either zero,
+   meaning it is free, or the offset of an entry plus one. The top bit is set
+   once the entry has been used. Like the strings hashmap, the slots are kept
+   at most half full, and their number is a power of two. */
+u8_t const* cache_old_data = 0;
+size_t cache_old_length = 0;
+u64_t* cache_slots = 0;
+size_t cache_slots_mask = 0;
+#define CACHE_SLOT_USED 0x8000000000000000ul
+
+/* The file is only valid up to cache_old_valid_length, which is less than the
+   length of the file if an earlier run was interrupted while writing it or if
+   there were too many entries to load. */
+size_t cache_old_valid_length = 0;
+size_t cache_old_entries = 0;
+size_t cache_used_entries = 0;
+size_t cache_new_entries = 0;
+
+void cache_load_entries() {
+  cache_read_data = cache_old_data;
+  cache_read_end = cache_old_length;
+  cache_read_index = sizeof(CACHE_MAGIC);
+  cache_read_failed = false;
+  if (cache_get_u32() != CACHE_VERSION) {
+    return;
+  }
+  size_t offset = cache_read_index;
+  cache_old_valid_length = offset;
+  while (offset < cache_old_length && cache_old_entries < limit_cache_entries) {
+    cache_read_index = offset;
+    u32_t entry_length = cache_get_u32();
+    u64_t hash = cache_get_u64();
+    if (cache_read_failed || entry_length < 12 || entry_length > cache_old_length - offset) {
+      return;
+    }
+    size_t slot_index = hash & cache_slots_mask;
+    while (cache_slots[slot_index]) {
+      slot_index = (slot_index + 1) & cache_slots_mask;
+    }
+    cache_slots[slot_index] = offset + 1;
+    cache_old_entries = cache_old_entries + 1;
+    offset = offset + entry_length;
+    cache_old_valid_length = offset;
+  }
+}
+
+/* Maps the cache from the previous run, if there is one. */
+void cache_load() {
+  i32_t fd = syscall_open(cache_filename, O_RDONLY, 0);
+  if (fd < 0) {
+    return;
+  }
+  i64_t length = syscall_lseek(fd, 0, SEEK_END);
+  if (length >= (i64_t) sizeof(CACHE_MAGIC) + 4) {
+    void* mapping = syscall_mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (!syscall_mmap_failed(mapping)) {
+      cache_old_data = mapping;
+      cache_old_length = length;
+      if (strings_equal_bytes(mapping, CACHE_MAGIC, sizeof(CACHE_MAGIC))) {
+        cache_load_entries();
+      }
+    }
+  }
+  syscall_close(fd);
+}
+
+void cache_error_opening(char const* filename) {
+  log_string("Got unix error code while trying to open \"");
+  log_string(filename);
+  log_line("\".");
+  syscall_exit(1);
+}
+
+void cache_open(char const* filename) {
+  size_t length = 0;
+  while (filename[length]) {
+    length = length + 1;
+  }
+  if (length + 5 > MAX_FILENAME_LENGTH) {
+    log_line("The name of the cache file is too long.");
+    syscall_exit(1);
+  }
+  copy_bytes(cache_temporary_filename, filename, length);
+  copy_bytes(&cache_temporary_filename[length], ".tmp", 5);
+  cache_enabled = true;
+  cache_filename = filename;
+  cache_buffer = memory_allocate(CACHE_BUFFER_CAPACITY);
+  size_t slot_count = 1;
+  while (slot_count < 2 * limit_cache_entries) {
+    slot_count = 2 * slot_count;
+  }
+  cache_slots = memory_allocate(slot_count * sizeof(u64_t));
+  cache_slots_mask = slot_count - 1;
+  cache_load();
+  if (cache_old_valid_length == cache_old_length && cache_old_length > 0) {
+    cache_fd = syscall_open(filename, O_WRONLY | O_APPEND, 0);
+  } else {
+    /* The old file is unusable or damaged, so it is only kept around to copy
+       its valid entries from, and the new entries go to a fresh file. */
+    cache_fd = syscall_open(cache_temporary_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    cache_put(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    cache_put_u32(CACHE_VERSION);
+  }
+  if (cache_fd < 0) {
+    cache_error_opening(filename);
+  }
+}
+
+/* Writes the entries of the old file that were used by this run. */
+void cache_write_used_entries() {
+  size_t slot_index = 0;
+  while (slot_index <= cache_slots_mask) {
+    u64_t slot = cache_slots[slot_index];
+    if (slot & CACHE_SLOT_USED) {
+      size_t offset = (slot & ~CACHE_SLOT_USED) - 1;
+      cache_read_data = cache_old_data;
+      cache_read_end = cache_old_length;
+      cache_read_index = offset;
+      cache_read_failed = false;
+      cache_write(&cache_old_data[offset], cache_get_u32());
+    }
+    slot_index = slot_index + 1;
+  }
+}
+
+void cache_close() {
+  cache_flush();
+  syscall_close(cache_fd);
+  bool_t appended = cache_old_valid_length == cache_old_length && cache_old_length > 0;
+  size_t garbage = cache_old_entries - cache_used_entries;
+  if (appended && garbage <= cache_used_entries + cache_new_entries) {
+    return;
+  }
+  if (appended) {
+    /* The new entries were appended to the old file, so they have to be
+       copied out of it before it is replaced. */
+    i32_t fd = syscall_open(cache_filename, O_RDONLY, 0);
+    if (fd < 0) {
+      cache_error_opening(cache_filename);
+    }
+    i64_t length = syscall_lseek(fd, 0, SEEK_END);
+    void* mapping = syscall_mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (length < 0 || syscall_mmap_failed(mapping)) {
+      cache_error_opening(cache_filename);
+    }
+    syscall_close(fd);
+    cache_fd = syscall_open(cache_temporary_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (cache_fd < 0) {
+      cache_error_opening(cache_temporary_filename);
+    }
+    cache_write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    u32_t version = CACHE_VERSION;
+    cache_write(&version, sizeof(version));
+    cache_write_used_entries();
+    cache_write((u8_t const*) mapping + cache_old_length, length - cache_old_length);
+  } else {
+    /* The new entries are already in the temporary file, so the used entries
+       of the old file just need to be added. */
+    cache_fd = syscall_open(cache_temporary_filename, O_WRONLY | O_APPEND, 0);
+    if (cache_fd < 0) {
+      cache_error_opening(cache_temporary_filename);
+    }
+    cache_write_used_entries();
+  }
+  syscall_close(cache_fd);
+  if (syscall_rename(cache_temporary_filename, cache_filename) < 0) {
+    log_string("Got unix error code while trying to replace \"");
+    log_string(cache_filename);
+    log_line("\".");
+    syscall_exit(1);
+  }
+}
+
+void cache_begin_entry() {
+  if (cache_buffer_length > CACHE_BUFFER_CAPACITY / 2) {
+    cache_flush();
+  }
+  cache_entry_start = cache_buffer_length;
+  cache_overflowed = false;
+}
+
+void cache_set_u32(size_t position, u32_t value) {
+  copy_bytes(&cache_buffer[position], &value, sizeof(value));
+}
+
+void cache_end_entry() {
+  if (cache_overflowed) {
+    cache_buffer_length = cache_entry_start;
+    cache_overflowed = false;
+  } else {
+    cache_set_u32(cache_entry_start, cache_buffer_length - cache_entry_start);
+  }
+}
+
+/* Returns the offset just past the function declaration that starts at the
+   given index, or 0 if there is no function declaration there or it doesn't
+   end. Function headers can't contain '.' or '{', and bodies can't contain
+   '}', so no parsing is needed. */
+size_t cache_fn_declaration_end(size_t index) {
+  char const* data = parse_read_buffer;
+  size_t length = parse_read_buffer_length;
+  if (index + 2 > length || data[index] != 'f' || data[index + 1] != 'n') {
+    return 0;
+  }
+  index = scan_find(data, index, length, '.', '{');
+  if (index < length && data[index] == '{') {
+    index = scan_find(data, index, length, '}', '}');
+  }
+  if (index == length) {
+    return 0;
+  }
+  return index + 1;
+}
+
+bool_t cache_dependencies_match() {
+  u32_t count = cache_get_u32();
+  u32_t i = 0;
+  while (i < count && !cache_read_failed) {
+    cache_dependency_kind_t kind = cache_get_u8();
+    strings_id_t name = cache_get_string();
+    u64_t hash = cache_get_u64();
+    if (cache_read_failed || kind > cache_dependency_kind_constant || cache_dependency_hash(kind, name) != hash) {
+      return false;
+    }
+    i = i + 1;
+  }
+  return !cache_read_failed;
+}
+
+/* Notes the calls of a function from the dependencies of its entry, which are
+   recorded in the order the calls are parsed, so that the same prototypes are
+   emitted in front of it as when it is parsed. */
+void cache_note_calls(size_t dependencies_index) {
+  cache_read_index = dependencies_index;
+  u32_t count = cache_get_u32();
+  u32_t i = 0;
+  while (i < count) {
+    cache_dependency_kind_t kind = cache_get_u8();
+    strings_id_t name = cache_get_string();
+    cache_get_u64();
+    if (kind == cache_dependency_kind_fn) {
+      parse_note_call(name);
+    }
+    i = i + 1;
+  }
+}
+
+/* Looks for an entry for a function with the given bytes whose dependencies
+   are unchanged. If there is one, the function's signature is restored and its
+   code is emitted. */
+bool_t cache_reuse(u64_t hash, char const* source, size_t length) {
+  size_t slot_index = hash & cache_slots_mask;
+  while (cache_slots[slot_index]) {
+    u64_t slot = cache_slots[slot_index];
+    size_t offset = (slot & ~CACHE_SLOT_USED) - 1;
+    cache_read_data = cache_old_data;
+    cache_read_end = cache_old_length;
+    cache_read_index = offset;
+    cache_read_failed = false;
+    u32_t entry_length = cache_get_u32();
+    cache_read_end = offset + entry_length;
+    if (cache_get_u64() == hash && cache_get_u64() == length && cache_get_matches(source, length)) {
+      size_t dependencies_index = cache_read_index;
+      if (cache_dependencies_match()) {
+        strings_id_t name = cache_get_string();
+        parse_fn_signature_t signature = cache_get_fn_signature();
+        u32_t code_length = cache_get_u32();
+        if (!cache_read_failed && code_length == cache_read_end - cache_read_index) {
+          size_t code_index = cache_read_index;
+          parse_declare_fn(name, &signature);
+          cache_note_calls(dependencies_index);
+          emit_forward_prototypes();
+          emit_lstring((char const*) &cache_read_data[code_index], code_length);
+          if (!(slot & CACHE_SLOT_USED)) {
+            cache_slots[slot_index] = slot | CACHE_SLOT_USED;
+            cache_used_entries = cache_used_entries + 1;
+          }
+          return true;
+        }
+      }
+    }
+    slot_index = (slot_index + 1) & cache_slots_mask;
+  }
+  return false;
+}
+
+/* Translates the declaration at the current location, either from the cache
+   or by parsing and emitting it, in which case a new entry is saved. */
+void cache_translate_declaration() {
+  size_t start = current_location.index;
+  size_t end = cache_fn_declaration_end(start);
+  u64_t hash = 0;
+  if (end) {
+    hash = cache_hash_bytes(FNV64_OFFSET_BASIS, (u8_t const*) &parse_read_buffer[start], end - start);
+    if (cache_reuse(hash, &parse_read_buffer[start], end - start)) {
+      current_location.index = end;
+      return;
+    }
+  }
+  cache_declaration_serial = cache_declaration_serial + 1;
+  cache_dependencies_count = 0;
+  cache_recording = end != 0;
+  parse_declaration();
+  cache_recording = false;
+  if (!end || parse_declaration_kind != declaration_kind_fn || current_location.index != end) {
+    emit_declaration();
+    return;
+  }
+  cache_begin_entry();
+  cache_put_u32(0);
+  cache_put_u64(hash);
+  cache_put_u64(end - start);
+  cache_put(&parse_read_buffer[start], end - start);
+  cache_put_u32(cache_dependencies_count);
+  size_t i = 0;
+  while (i < cache_dependencies_count) {
+    cache_dependency_t dependency = cache_dependencies[i];
+    u64_t dependency_hash = cache_dependency_hash(dependency.kind, dependency.name);
+    cache_put_u8(dependency.kind);
+    cache_put_string(dependency.name);
+    cache_put_u64(dependency_hash);
+    i = i + 1;
+  }
+  cache_put_string(parse_declaration_name);
+  cache_put_fn_signature(&parse_declaration_signature);
+  size_t code_length_position = cache_buffer_length;
+  cache_put_u32(0);
+  emit_forward_prototypes();
+  emit_capturing = true;
+  emit_capture_start = emit_buffer_length;
+  emit_declaration();
+  cache_put(&emit_buffer[emit_capture_start], emit_buffer_length - emit_capture_start);
+  emit_capturing = false;
+  if (!cache_overflowed) {
+    cache_set_u32(code_length_position, cache_buffer_length - code_length_position - 4);
+    cache_new_entries = cache_new_entries + 1;
+  }
+  cache_end_entry();
+}
+
+/* -------------------------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------------------
+ * INTERFACES
+ *
+ * An interface file holds the declarations of a set of source files, without
+ * function bodies, so that code using them can be translated without parsing
+ * their sources. The records are the same as in the cache, except that
+ * strings are stored as indexes into a table at the end of the file, so that
+ * each distinct string is only interned once when the file is loaded.
+ *
+ * The file starts with INTERFACE_MAGIC and INTERFACE_VERSION, followed by the
+ * declarations, each of which is a u8 declaration kind, a name, and then:
+ *
+ *   struct  u16 number of fields, followed by the name and type of each
+ *   const   u64 value
+ *   fn      the signature record
+ *
+ * After the declarations comes the string table, with each string stored as a
+ * u32 length followed by the bytes, and the file ends with the u64 offset of
+ * the string table and the u32 number of strings in it.
+ * -------------------------------------------------------------------------------- */
+
+char const INTERFACE_MAGIC[8] = "MINCINTF";
+#define INTERFACE_VERSION 1
+#define INTERFACE_TRAILER_LENGTH 12
+
+bool_t interface_writing = false;
+
+void interface_open(char const* filename) {
+  cache_fd = syscall_open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (cache_fd < 0) {
+    cache_error_opening(filename);
+  }
+  interface_writing = true;
+  cache_strings_indexed = true;
+  cache_buffer = memory_allocate(CACHE_BUFFER_CAPACITY);
+  cache_put(INTERFACE_MAGIC, sizeof(INTERFACE_MAGIC));
+  cache_put_u32(INTERFACE_VERSION);
+}
+
+/* Writes the most recently parsed or loaded declaration. */
+void interface_put_declaration() {
+  strings_id_t name = parse_declaration_name;
+  cache_begin_entry();
+  cache_put_u8(parse_declaration_kind);
+  cache_put_string(name);
+  if (parse_declaration_kind == declaration_kind_struct) {
+    struct_info_t info = parse_declaration_struct;
+    cache_put_u16(info.field_count);
+    size_t i = 0;
+    while (i < info.field_count) {
+      struct_field_t field = struct_fields[info.first_field_index + i];
+      cache_put_string(field.name);
+      cache_put_type(field.type);
+      i = i + 1;
+    }
+  } else if (parse_declaration_kind == declaration_kind_const) {
+    cache_put_u64(parse_constants[name].value);
+  } else {
+    cache_put_fn_signature(&parse_declaration_signature);
+  }
+  if (cache_overflowed) {
+    log_line("A declaration is too large to be written to an interface file.");
+    syscall_exit(1);
+  }
+}
+
+void interface_close() {
+  u64_t string_table_offset = cache_flushed_length + cache_buffer_length;
+  u32_t i = 0;
+  while (i < cache_string_table_count) {
+    strings_id_t id = cache_string_table[i];
+    cache_begin_entry();
+    cache_put_u32(strings_lengths[id]);
+    cache_put(strings_pointers[id], strings_lengths[id]);
+    if (cache_overflowed) {
+      log_line("A string is too large to be written to an interface file.");
+      syscall_exit(1);
+    }
+    i = i + 1;
+  }
+  cache_put_u64(string_table_offset);
+  cache_put_u32(cache_string_table_count);
+  cache_flush();
+  syscall_close(cache_fd);
+  cache_strings_indexed = false;
+  interface_writing = false;
+}
+
+void interface_error_invalid(char const* filename) {
+  log_string("The file \"");
+  log_string(filename);
+  log_line("\" is not a valid interface file.");
+  syscall_exit(1);
+}
+
+/* Reads the string table of the mapped interface file, interning each
+   string. */
+void interface_load_strings(char const* filename) {
+  cache_read_index = cache_read_end - INTERFACE_TRAILER_LENGTH;
+  u64_t string_table_offset = cache_get_u64();
+  u32_t count = cache_get_u32();
+  if (string_table_offset < sizeof(INTERFACE_MAGIC) + 4
+      || string_table_offset > cache_read_end - INTERFACE_TRAILER_LENGTH
+      || count > limit_strings) {
+    interface_error_invalid(filename);
+  }
+  cache_read_index = string_table_offset;
+  cache_read_end = cache_read_end - INTERFACE_TRAILER_LENGTH;
+  cache_strings_indexed = false;
+  u32_t i = 0;
+  while (i < count) {
+    cache_string_ids[i] = cache_get_string();
+    i = i + 1;
+  }
+  if (cache_read_failed) {
+    interface_error_invalid(filename);
+  }
+  cache_string_ids_count = count;
+  cache_read_index = sizeof(INTERFACE_MAGIC) + 4;
+  cache_read_end = string_table_offset;
 }
 
-u8_t parse_identifier_start_chars[256] = {0};
-u8_t parse_identifier_rest_chars[256] = {0};
-u8_t parse_digit_chars[256] = {0};
-u8_t parse_operator_chars[256] = {0};
-
-void parse_init_char_tables() {
-  size_t c = 'a';
-  while (c <= 'z') {
-    parse_identifier_start_chars[c] = 1;
-    parse_identifier_rest_chars[c] = 1;
-    c = c + 1;
-  }
-  c = '0';
-  while (c <= '9') {
-    parse_identifier_rest_chars[c] = 1;
-    parse_digit_chars[c] = 1;
-    c = c + 1;
-  }
-  parse_identifier_rest_chars['_'] = 1;
-  parse_operator_chars['<'] = 1;
-  parse_operator_chars['>'] = 1;
-  parse_operator_chars['+'] = 1;
-  parse_operator_chars['-'] = 1;
-  parse_operator_chars['*'] = 1;
-  parse_operator_chars['/'] = 1;
-  parse_operator_chars['='] = 1;
-  parse_operator_chars['&'] = 1;
-  parse_operator_chars['|'] = 1;
-  parse_operator_chars['$'] = 1;
-  parse_operator_chars['!'] = 1;
-  parse_operator_chars['?'] = 1;
-  parse_operator_chars['^'] = 1;
+/* Loads the declarations in an interface file as if they had been parsed.
+   When translating, the declarations are emitted too, which gives function
+   prototypes and struct definitions. When writing an interface, they are only
+   made available to the source files, and are not written again. */
+void interface_load(char const* filename, u32_t index) {
+  i32_t fd = syscall_open(filename, O_RDONLY, 0);
+  if (fd < 0) {
+    cache_error_opening(filename);
+  }
+  i64_t length = syscall_lseek(fd, 0, SEEK_END);
+  if (length < (i64_t) (sizeof(INTERFACE_MAGIC) + 4 + INTERFACE_TRAILER_LENGTH)) {
+    interface_error_invalid(filename);
+  }
+  void* mapping = syscall_mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (syscall_mmap_failed(mapping)) {
+    cache_error_opening(filename);
+  }
+  syscall_close(fd);
+  cache_read_data = mapping;
+  cache_read_index = 0;
+  cache_read_end = length;
+  cache_read_failed = false;
+  if (!strings_equal_bytes(mapping, INTERFACE_MAGIC, sizeof(INTERFACE_MAGIC))) {
+    interface_error_invalid(filename);
+  }
+  cache_read_index = sizeof(INTERFACE_MAGIC);
+  if (cache_get_u32() != INTERFACE_VERSION) {
+    interface_error_invalid(filename);
+  }
+  interface_load_strings(filename);
+  cache_strings_indexed = true;
+  parse_declaration_ordinal = (u64_t) index << 32;
+  while (cache_read_index < cache_read_end) {
+    parse_declaration_ordinal = parse_declaration_ordinal + 1;
+    declaration_kind_t kind = cache_get_u8();
+    strings_id_t name = cache_get_string();
+    if (kind == declaration_kind_struct) {
+      u16_t field_count = cache_get_u16();
+      u16_t i = 0;
+      while (i < field_count && !cache_read_failed) {
+        parse_fields[i].name = cache_get_string();
+        parse_fields[i].type = cache_get_type();
+        i = i + 1;
+      }
+      if (cache_read_failed) {
+        interface_error_invalid(filename);
+      }
+      parse_declaration_struct = (struct_info_t) {
+        .field_count = field_count,
+        .first_field_index = parse_add_struct_fields(parse_fields, field_count),
+        .exists = true
+      };
+      parse_declare_struct(name, parse_declaration_struct);
+    } else if (kind == declaration_kind_const) {
+      u64_t value = cache_get_u64();
+      if (cache_read_failed) {
+        interface_error_invalid(filename);
+      }
+      parse_declare_constant(name, value);
+    } else if (kind == declaration_kind_fn) {
+      parse_declaration_signature = cache_get_fn_signature();
+      if (cache_read_failed) {
+        interface_error_invalid(filename);
+      }
+      parse_declare_fn(name, &parse_declaration_signature);
+    } else {
+      interface_error_invalid(filename);
+    }
+    parse_declaration_kind = kind;
+    parse_declaration_name = name;
+    parse_declaration_has_body = false;
+    if (!interface_writing && !parse_prescanning) {
+      emit_declaration();
+    }
+  }
+  cache_strings_indexed = interface_writing;
+  cache_string_ids_count = 0;
+  syscall_munmap(mapping, length);
 }
 
-strings_id_t parse_permanent_identifier() {
-  size_t start_index = current_location.index;;
-  char c = peek_char();
-  if (parse_identifier_start_chars[(size_t) c]) {
-    do {
-      advance_char();
-      c = peek_char();
-    } while (parse_identifier_rest_chars[(size_t) c]);
-    size_t length = current_location.index - start_index;
-    return strings_id(&parse_read_buffer[start_index], length);
-  } else {
-    advance_char();
-    parse_log_current_location();
-    log_line("Expected identifier.");
-    parse_log_current_location_line_with_column_marker();
-    syscall_exit(1);
-    return 0;
+/* -------------------------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------------------
+ * STATISTICS
+ *
+ * With '-s', translate reports how much of each limited array the input used,
+ * the declarations that came closest to the limits on a single declaration,
+ * and how far lookups in the strings hashmap have to probe, so that the limits
+ * can be sized for a workload and a poor hash shows up before it is slow.
+ * Each thread keeps its own peaks and counts, which are merged when it is
+ * done.
+ * -------------------------------------------------------------------------------- */
+
+bool_t stats_enabled = false;
+__thread size_t stats_declaration_counts[3];
+__thread size_t stats_peak_expressions = 0;
+__thread strings_id_t stats_peak_expressions_name = 0;
+__thread size_t stats_peak_local_variables = 0;
+__thread strings_id_t stats_peak_local_variables_name = 0;
+
+size_t stats_total_declaration_counts[3];
+size_t stats_total_work_counts[work_count];
+/* Each peak is kept together with the name of its declaration, with the peak
+   in the upper half and the name in the lower half, so that threads can merge
+   both at once with a compare-and-swap. */
+u64_t stats_total_peak_expressions = 0;
+u64_t stats_total_peak_local_variables = 0;
+
+/* Notes the declaration that was just translated. Expressions are only added
+   while parsing a function body, so parse_expression_index is what the
+   declaration used, or what an earlier one did. */
+void stats_note_declaration(declaration_kind_t kind) {
+  stats_declaration_counts[kind] = stats_declaration_counts[kind] + 1;
+  if (parse_expression_index > stats_peak_expressions) {
+    stats_peak_expressions = parse_expression_index;
+    stats_peak_expressions_name = parse_declaration_name;
+  }
+  if (parse_local_variables_peak > stats_peak_local_variables) {
+    stats_peak_local_variables = parse_local_variables_peak;
+    stats_peak_local_variables_name = parse_declaration_name;
   }
+  parse_local_variables_peak = 0;
 }
 
-strings_id_t parse_operator() {
-  size_t start_index = current_location.index;;
-  char c = peek_char();
-  if (parse_operator_chars[(size_t) c]) {
-    do {
-      advance_char();
-      c = peek_char();
-    } while (parse_operator_chars[(size_t) c]);
-    size_t length = current_location.index - start_index;
-    return strings_id(&parse_read_buffer[start_index], length);
-  } else {
-    advance_char();
-    parse_log_current_location();
-    log_line("Expected operator.");
-    parse_log_current_location_line_with_column_marker();
-    syscall_exit(1);
-    return 0;
+/* Raises a total peak to the given one if it is higher. */
+void stats_merge_peak(u64_t* total, size_t peak, strings_id_t name) {
+  u64_t seen = __atomic_load_n(total, __ATOMIC_RELAXED);
+  while (peak > seen >> 32) {
+    if (__atomic_compare_exchange_n(total, &seen, (u64_t) peak << 32 | name, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+      return;
+    }
   }
 }
 
-u64_t array_lengths[MAX_ARRAY_LENGTHS];
-size_t array_lengths_index = 0;
+void stats_finish_thread() {
+  if (!stats_enabled) {
+    return;
+  }
+  size_t kind = 0;
+  while (kind < 3) {
+    __atomic_fetch_add(&stats_total_declaration_counts[kind], stats_declaration_counts[kind], __ATOMIC_RELAXED);
+    kind = kind + 1;
+  }
+  size_t work = 0;
+  while (work < work_count) {
+    __atomic_fetch_add(&stats_total_work_counts[work], work_counts[work], __ATOMIC_RELAXED);
+    work = work + 1;
+  }
+  stats_merge_peak(&stats_total_peak_expressions, stats_peak_expressions, stats_peak_expressions_name);
+  stats_merge_peak(&stats_total_peak_local_variables, stats_peak_local_variables, stats_peak_local_variables_name);
+}
 
-typedef struct type_t {
-  /* The named type from which this type is derived. */
-  strings_id_t base;
-  /* For example, i32*** has three modifiers (each pointer is a modifier). */
-  u8_t modifier_count;
-  /* The modifier_count least significant bits say whether each modifier is a pointer (0) or an array (1) */
-  u8_t modifiers;
-  /* If any of the modifiers are arrays, then the lengths of those arrays will
-     be stored in array_lengths, starting at first_array_length_index. */
-  u16_t first_array_length_index;
-} type_t;
+void stats_log_usage(char const* name, size_t used, size_t capacity) {
+  log_string(name);
+  log_string(": ");
+  log_size(used);
+  log_string(" of ");
+  log_size(capacity);
+  log_newline();
+}
 
-typedef struct struct_field_t {
-  strings_id_t name;
-  type_t type;
-} struct_field_t;
+void stats_log_peak(char const* name, u64_t total_peak, size_t capacity) {
+  size_t peak = total_peak >> 32;
+  strings_id_t declaration = (u32_t) total_peak;
+  log_string(name);
+  log_string(": ");
+  log_size(peak);
+  log_string(" of ");
+  log_size(capacity);
+  if (peak) {
+    log_string(", in '");
+    log_lstring(strings_pointers[declaration], strings_lengths[declaration]);
+    log_string("'");
+  }
+  log_newline();
+}
 
-typedef struct struct_info_t {
-  u16_t field_count;
-  u16_t first_field_index;
-  bool_t exists;
-} struct_info_t;
+/* Prints how many strings in the hashmap are found after each number of
+   probes, in buckets that double in size. A string is found after as many
+   probes as its slot is past the slot its hash points at, plus one. */
+void stats_log_probes() {
+  size_t slot_count = strings_slots_mask + 1;
+  size_t buckets[64] = {0};
+  size_t bucket_count = 0;
+  size_t i = 0;
+  while (i < slot_count) {
+    u64_t slot = strings_slots[i];
+    if (slot) {
+      size_t probes = ((i - ((u32_t) (slot >> 32) & strings_slots_mask)) & strings_slots_mask) + 1;
+      size_t bucket = 0;
+      while (((size_t) 1 << bucket) < probes) {
+        bucket = bucket + 1;
+      }
+      buckets[bucket] = buckets[bucket] + 1;
+      if (bucket + 1 > bucket_count) {
+        bucket_count = bucket + 1;
+      }
+    }
+    i = i + 1;
+  }
+  log_line("probes per string:");
+  log_indent();
+  size_t bucket = 0;
+  while (bucket < bucket_count) {
+    size_t last = (size_t) 1 << bucket;
+    size_t first = bucket < 2 ? last : last / 2 + 1;
+    log_size(first);
+    if (first != last) {
+      log_string("-");
+      log_size(last);
+    }
+    log_string(": ");
+    log_size(buckets[bucket]);
+    log_newline();
+    bucket = bucket + 1;
+  }
+  log_dedent();
+}
 
-struct_field_t struct_fields[MAX_STRUCT_FIELDS];
-size_t struct_fields_index = 0;
-struct_info_t struct_infos[STRINGS_ID_MAP_LENGTH];
+/* Prints the statistics, to standard error. */
+void stats_report() {
+  stats_finish_thread();
+  /* The strings are counted from the hashmap, which leaves out the ids of
+     strings that lost a race to be added by another thread, so that the
+     counts don't depend on the number of threads. strings_data_index counts
+     whole regions, including what is left over at their ends, so the bytes
+     of the strings are added up instead. The built-in strings are neither in
+     the hashmap nor stored in strings_data. */
+  size_t strings_used = BUILTIN_STRINGS_COUNT;
+  size_t strings_data_used = 0;
+  size_t slot_index = 0;
+  while (slot_index <= strings_slots_mask) {
+    u64_t slot = strings_slots[slot_index];
+    if (slot) {
+      strings_used = strings_used + 1;
+      strings_data_used = strings_data_used + strings_lengths[(u32_t) slot - 1] + 1;
+    }
+    slot_index = slot_index + 1;
+  }
+  stats_log_usage("strings", strings_used, limit_strings);
+  stats_log_usage("strings-data", strings_data_used, limit_strings_data);
+  stats_log_usage("arguments", parse_fn_arguments_count, limit_fn_arguments);
+  stats_log_usage("struct-fields", struct_fields_index, MAX_STRUCT_FIELDS);
+  stats_log_usage("array-lengths", array_lengths_index, MAX_ARRAY_LENGTHS);
+  stats_log_peak("expressions", stats_total_peak_expressions, limit_expressions);
+  stats_log_peak("locals", stats_total_peak_local_variables, MAX_LOCAL_VARIABLES);
+  log_string("declarations: ");
+  log_size(stats_total_declaration_counts[declaration_kind_struct]);
+  log_string(" structs, ");
+  log_size(stats_total_declaration_counts[declaration_kind_const]);
+  log_string(" consts, ");
+  log_size(stats_total_declaration_counts[declaration_kind_fn]);
+  log_line(" fns");
+  stats_log_probes();
+  log_line("work:");
+  log_indent();
+  log_string("probes: ");
+  log_size(stats_total_work_counts[work_probes]);
+  log_newline();
+  log_string("compared: ");
+  log_size(stats_total_work_counts[work_compared]);
+  log_line(" bytes");
+  log_string("copied: ");
+  log_size(stats_total_work_counts[work_copied]);
+  log_line(" bytes");
+  log_string("steps: ");
+  log_size(stats_total_work_counts[work_steps]);
+  log_newline();
+  log_dedent();
+}
 
-typedef struct parse_local_variable_t {
-  strings_id_t name;
-  type_t type;
-} parse_local_variable_t;
+/* -------------------------------------------------------------------------------- */
 
-typedef struct parse_fn_signature_t {
-  bool_t exists;
-  u16_t arity;
-  parse_local_variable_t args[14];
-  type_t return_type;
-} parse_fn_signature_t;
+void parse_error_reading_file(char const* filename) {
+  log_string("Got unix error code while trying to read file \"");
+  log_string(filename);
+  log_line("\".");
+  syscall_exit(1);
+}
 
-parse_fn_signature_t parse_fn_signatures[STRINGS_ID_MAP_LENGTH];
+/* Each input file is mapped once, while prescanning, and stays mapped until
+   the end, since its chunks may be parsed by different threads. Interned
+   strings are copied into strings_data, so nothing refers to the mappings
+   after that. */
+typedef struct parse_file_t {
+  char const* data;
+  size_t length;
+} parse_file_t;
 
-typedef struct parse_constant_t {
-  bool_t exists;
-  u64_t value;
-} parse_constant_t;
+parse_file_t* parse_files = 0;
 
-parse_constant_t parse_constants[STRINGS_ID_MAP_LENGTH];
+/* A chunk is a run of whole declarations in one file, or a whole interface
+   file. The first ordinal is the position in the file of the declaration
+   before the first one in the chunk. */
+typedef struct parse_chunk_t {
+  u32_t file;
+  u32_t first_ordinal;
+  size_t start;
+  size_t end;
+} parse_chunk_t;
 
-u64_t parse_integer_constant() {
-  size_t c = (size_t) peek_char();
-  if (parse_digit_chars[c]) {
-    advance_char();
-    u64_t current = c - '0';
-    while (true) {
-      c = (size_t) peek_char();
-      if (parse_digit_chars[c]) {
-        advance_char();
-        size_t next = current * 10 + c - '0';
-        /* If incorporating a digit causes the accumulated value to go down, then
-          we must have overflowed, which means the literal denotes an
-          unrepresentable integer (at least, it is unrepresentable in 64 bits,
-          which is the size we care about).. */
-        if (next < current) {
-          parse_log_current_location();
-          log_line("Integer constant too large; it must be representable in 64 bits.");
-          parse_log_current_location_line_with_column_marker();
-          syscall_exit(1);
-        }
-        current = next;
-      } else {
-        break;
-      }
-    }
-    return current;
-  } else if (parse_identifier_start_chars[c]) {
-    strings_id_t name = parse_permanent_identifier();
-    parse_constant_t constant = parse_constants[name];
-    if (constant.exists) {
-      return constant.value;
-    } else {
-      parse_log_current_location();
-      log_string("Unknown integer constant '");
-      log_string(strings_pointers[name]);
-      log_line("'.");
-      parse_log_current_location_line_with_column_marker();
-      syscall_exit(1);
-      return 0;
+parse_chunk_t* parse_chunks = 0;
+u32_t parse_chunk_count = 0;
+
+/* Standard input, given as '-', is translated as it arrives instead of being
+   read whole first, so that generated code can be piped in at constant
+   memory. It is not prescanned, so its declarations have to come before
+   their use, and it can only come after the other input files. */
+bool_t parse_file_is_stream(u32_t index) {
+  return string_equal("-", (char*) parse_filenames[index]);
+}
+
+void parse_error_opening_file(char const* filename) {
+  log_string("Got unix error code while trying to open \"");
+  log_string(filename);
+  log_line("\".");
+  syscall_exit(1);
+}
+
+void parse_map_file(u32_t index) {
+  char const* filename = parse_filenames[index];
+  i32_t fd = syscall_open(filename, O_RDONLY, 0);
+  if (fd < 0) {
+    parse_error_opening_file(filename);
+  }
+  i64_t file_length = syscall_lseek(fd, 0, SEEK_END);
+  if (file_length < 0) {
+    parse_error_reading_file(filename);
+  }
+  /* Mapping an empty file fails, but there is nothing to parse anyway. The
+     pages are read in right away, so that the time it takes is counted as
+     reading instead of as lexing, where they would otherwise fault in. */
+  void* mapping = 0;
+  if (file_length > 0) {
+    mapping = syscall_mmap(0, file_length, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    if (syscall_mmap_failed(mapping)) {
+      parse_error_reading_file(filename);
     }
-  } else {
-    parse_log_current_location();
-    log_line("Expected literal or named integer constant.");
-    parse_log_current_location_line_with_column_marker();
-    syscall_exit(1);
+  }
+  syscall_close(fd);
+  parse_files[index] = (parse_file_t) { .data = mapping, .length = file_length };
+}
+
+/* When there are several source files, they are opened and read through an
+   io_uring instead of being mapped. The opens and reads of the files ahead
+   are in flight while the earlier ones are prescanned, so a cold page cache
+   costs about the time of the slowest file instead of the sum over all of
+   them. Errors are still reported in the order of the files. When io_uring
+   is not available, or the kernel turns out not to support opening or
+   reading through it, the files are mapped one by one. */
+#define reading_state_waiting 0
+#define reading_state_opening 1
+#define reading_state_reading 2
+#define reading_state_done 3
+#define reading_state_open_failed 4
+#define reading_state_read_failed 5
+#define reading_state_unsupported 6
+
+typedef struct reading_file_t {
+  i32_t fd;
+  u8_t state;
+  size_t read_length;
+} reading_file_t;
+
+bool_t reading_enabled = false;
+i32_t reading_ring_fd = -1;
+u32_t* reading_sq_tail = 0;
+u32_t reading_sq_mask = 0;
+io_uring_sqe_t* reading_sqes = 0;
+u32_t* reading_cq_head = 0;
+u32_t* reading_cq_tail = 0;
+u32_t reading_cq_mask = 0;
+io_uring_cqe_t* reading_cqes = 0;
+void* reading_mappings[3] = { 0 };
+size_t reading_mapping_lengths[3] = { 0 };
+reading_file_t* reading_files = 0;
+u32_t reading_file_count = 0;
+u32_t reading_next_open = 0;
+u32_t reading_queued = 0;
+u32_t reading_in_flight = 0;
+/* Set once an operation fails in a way that means the kernel doesn't support
+   it, after which no more files are opened through the ring. */
+bool_t reading_unsupported = false;
+
+/* Maps one of the regions the kernel shares for the ring. */
+void* reading_map_ring(size_t length, u64_t offset, u32_t mapping) {
+  void* address = syscall_mmap(0, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, reading_ring_fd, offset);
+  if (syscall_mmap_failed(address)) {
     return 0;
   }
+  reading_mappings[mapping] = address;
+  reading_mapping_lengths[mapping] = length;
+  return address;
 }
 
-typedef u8_t expression_kind_t;
-#define expression_kind_operation 0
-#define expression_kind_operator 1
-#define expression_kind_integer 2
-#define expression_kind_local 3
-#define expression_kind_constant 4
-#define expression_kind_group 5
-#define expression_kind_cast 6
-#define expression_kind_ascription 7
+void reading_finish() {
+  u32_t i = 0;
+  while (i < 3) {
+    if (reading_mappings[i]) {
+      syscall_munmap(reading_mappings[i], reading_mapping_lengths[i]);
+      reading_mappings[i] = 0;
+    }
+    i = i + 1;
+  }
+  if (reading_ring_fd >= 0) {
+    syscall_close(reading_ring_fd);
+    reading_ring_fd = -1;
+  }
+  reading_enabled = false;
+}
 
-parse_local_variable_t parse_local_variables[MAX_LOCAL_VARIABLES];
-size_t parse_local_variables_index = 0;
+/* Sets up the ring for reading the source files among the given ones, and
+   returns false if it can't be used. */
+bool_t reading_start(u32_t file_count) {
+  u32_t source_count = 0;
+  u32_t i = 0;
+  while (i < file_count) {
+    if (!string_ends_with(parse_filenames[i], ".minci") && !parse_file_is_stream(i)) {
+      source_count = source_count + 1;
+    }
+    i = i + 1;
+  }
+  if (source_count < 2) {
+    return false;
+  }
+  io_uring_params_t params = { 0 };
+  i64_t ring_fd = syscall_io_uring_setup(READING_QUEUE_LENGTH, &params);
+  if (ring_fd < 0) {
+    return false;
+  }
+  reading_ring_fd = ring_fd;
+  /* Opening and reading came in Linux 5.6, along with this feature, and the
+     kernels before it fail those operations with -EINVAL. */
+  if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+    reading_finish();
+    return false;
+  }
+  u8_t* sq_ring = reading_map_ring(params.sq_offsets.array + params.sq_entries * sizeof(u32_t), IORING_OFF_SQ_RING, 0);
+  u8_t* cq_ring = reading_map_ring(params.cq_offsets.cqes + params.cq_entries * sizeof(io_uring_cqe_t), IORING_OFF_CQ_RING, 1);
+  reading_sqes = reading_map_ring(params.sq_entries * sizeof(io_uring_sqe_t), IORING_OFF_SQES, 2);
+  if (!sq_ring || !cq_ring || !reading_sqes) {
+    reading_finish();
+    return false;
+  }
+  reading_sq_tail = (u32_t*) (sq_ring + params.sq_offsets.tail);
+  reading_sq_mask = *(u32_t*) (sq_ring + params.sq_offsets.ring_mask);
+  reading_cq_head = (u32_t*) (cq_ring + params.cq_offsets.head);
+  reading_cq_tail = (u32_t*) (cq_ring + params.cq_offsets.tail);
+  reading_cq_mask = *(u32_t*) (cq_ring + params.cq_offsets.ring_mask);
+  reading_cqes = (io_uring_cqe_t*) (cq_ring + params.cq_offsets.cqes);
+  /* Each submission queue entry is always submitted from its own slot. */
+  u32_t* sq_array = (u32_t*) (sq_ring + params.sq_offsets.array);
+  i = 0;
+  while (i < params.sq_entries) {
+    sq_array[i] = i;
+    i = i + 1;
+  }
+  reading_files = memory_allocate(file_count * sizeof(reading_file_t));
+  reading_file_count = file_count;
+  reading_next_open = 0;
+  reading_queued = 0;
+  reading_in_flight = 0;
+  reading_unsupported = false;
+  reading_enabled = true;
+  return true;
+}
 
-typedef union expression_data_t {
-  /* Data is the id for one of (a) the name of the operation or operator, (b)
-    the identifier, or (c) the digits of the integer, depending on the kind. */
-  strings_id_t name;
-  /* Type is active when the kind is cast or ascription, in which case it is
-      the type being ascribed or casted to. */
-  type_t type;
-  /* Group expressions use neither data nor type. */
-} expression_data_t;
+/* The user data of an entry is the index of its file, with the lowest bit
+   telling reads from opens. */
+void reading_queue(io_uring_sqe_t entry) {
+  u32_t tail = *reading_sq_tail;
+  reading_sqes[tail & reading_sq_mask] = entry;
+  __atomic_store_n(reading_sq_tail, tail + 1, __ATOMIC_RELEASE);
+  reading_queued = reading_queued + 1;
+  reading_in_flight = reading_in_flight + 1;
+}
 
-typedef struct expression_t {
-  expression_kind_t kind;
-  /* Arity is the number of child expression. The field is not needed for
-     operator or group expressions, since the arity is always 2 or 1
-     respectively, but it _is_ needed for function calls. */
-  u8_t arity;
-  expression_data_t data;
-} expression_t;
+void reading_queue_read(u32_t index) {
+  size_t remaining = parse_files[index].length - reading_files[index].read_length;
+  reading_queue((io_uring_sqe_t) {
+    .opcode = IORING_OP_READ,
+    .fd = reading_files[index].fd,
+    .offset = reading_files[index].read_length,
+    .address = (u64_t) parse_files[index].data + reading_files[index].read_length,
+    .length = remaining < READING_MAX_READ ? remaining : READING_MAX_READ,
+    .user_data = ((u64_t) index << 1) | 1
+  });
+}
 
-expression_t parse_expressions[MAX_EXPRESSIONS];
-size_t parse_expression_index = 0;
+/* Opens the next source files while there is room in the ring. */
+void reading_queue_opens() {
+  while (!reading_unsupported && reading_in_flight < READING_QUEUE_LENGTH && reading_next_open < reading_file_count) {
+    u32_t index = reading_next_open;
+    reading_next_open = reading_next_open + 1;
+    if (string_ends_with(parse_filenames[index], ".minci") || parse_file_is_stream(index)) {
+      continue;
+    }
+    reading_files[index].state = reading_state_opening;
+    reading_queue((io_uring_sqe_t) {
+      .opcode = IORING_OP_OPENAT,
+      .fd = AT_FDCWD,
+      .address = (u64_t) parse_filenames[index],
+      .operation_flags = O_RDONLY,
+      .user_data = (u64_t) index << 1
+    });
+  }
+}
 
-void parse_shift_expressions_starting_at(size_t starting_at) {
-  size_t i = parse_expression_index + 1;
-  while (i > starting_at) {
-    parse_expressions[i] = parse_expressions[i - 1];
-    i = i - 1;
+void reading_fail(u32_t index, u8_t state) {
+  if (reading_files[index].state == reading_state_reading) {
+    syscall_close(reading_files[index].fd);
   }
+  reading_files[index].state = state;
 }
 
-type_t parse_type() {
-  if (!parse_exactly("`")) {
-    parse_log_current_location();
-    log_line("Expected '`' to begin type.");
-    parse_log_current_location_line_with_column_marker();
-    syscall_exit(1);
+void reading_complete(io_uring_cqe_t entry) {
+  u32_t index = entry.user_data >> 1;
+  reading_in_flight = reading_in_flight - 1;
+  if (entry.result == -EINVAL || entry.result == -EOPNOTSUPP) {
+    /* The kernel doesn't support the operation, which may still happen if it
+       was held back from the ring despite having the feature, so the file is
+       mapped instead, which reports any real error. */
+    reading_unsupported = true;
+    if (parse_files[index].data) {
+      syscall_munmap((void*) parse_files[index].data, parse_files[index].length);
+      parse_files[index] = (parse_file_t) { .data = 0, .length = 0 };
+    }
+    reading_fail(index, reading_state_unsupported);
+    return;
   }
-  strings_id_t base = parse_permanent_identifier();
-  type_t result = {
-    .base = base,
-    .modifier_count = 0,
-    .modifiers = 0,
-    .first_array_length_index = array_lengths_index
-  };
-  while (true) {
-    char c = peek_char();
-    if (c == '*') {
-      advance_char();
-      result.modifier_count = result.modifier_count << 1;
-    } else if (c == '[') {
-      advance_char();
-      ensure_array_space(array_lengths_index, MAX_ARRAY_LENGTHS, "array_lengths");
-      u64_t length = parse_integer_constant();
-      array_lengths[array_lengths_index] = length;
-      array_lengths_index = array_lengths_index + 1;
-      if (!parse_exactly("]")) {
-        parse_log_current_location();
-        log_line("Expected ']' after array size.");
-        parse_log_current_location_line_with_column_marker();
-        syscall_exit(1);
+  if (!(entry.user_data & 1)) {
+    if (entry.result < 0) {
+      reading_fail(index, reading_state_open_failed);
+      return;
+    }
+    reading_files[index].fd = entry.result;
+    reading_files[index].state = reading_state_reading;
+    i64_t file_length = syscall_lseek(entry.result, 0, SEEK_END);
+    if (file_length < 0) {
+      reading_fail(index, reading_state_read_failed);
+      return;
+    }
+    parse_files[index].length = file_length;
+    /* Like mapping a directory, making room for its claimed length fails. */
+    if (file_length > 0) {
+      void* data = syscall_mmap(0, file_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (syscall_mmap_failed(data)) {
+        reading_fail(index, reading_state_read_failed);
+        return;
       }
-    } else {
+      parse_files[index].data = data;
+    }
+  } else if (entry.result < 0) {
+    reading_fail(index, reading_state_read_failed);
+    return;
+  } else if (entry.result == 0) {
+    /* The file got shorter since its length was taken. */
+    parse_files[index].length = reading_files[index].read_length;
+  } else {
+    reading_files[index].read_length = reading_files[index].read_length + entry.result;
+  }
+  if (reading_files[index].read_length < parse_files[index].length) {
+    reading_queue_read(index);
+  } else {
+    syscall_close(reading_files[index].fd);
+    reading_files[index].state = reading_state_done;
+  }
+}
+
+/* Waits until the file with the given index has been read, keeping the files
+   after it in flight meanwhile. */
+void reading_wait(u32_t index) {
+  char const* filename = parse_filenames[index];
+  while (reading_files[index].state < reading_state_done) {
+    if (reading_unsupported && reading_files[index].state == reading_state_waiting) {
+      reading_files[index].state = reading_state_unsupported;
       break;
     }
+    reading_queue_opens();
+    i64_t result = syscall_io_uring_enter(reading_ring_fd, reading_queued, 1, IORING_ENTER_GETEVENTS);
+    if (result < 0 && result != -EINTR) {
+      parse_error_reading_file(filename);
+    }
+    if (result > 0) {
+      reading_queued = reading_queued - result;
+    }
+    u32_t head = *reading_cq_head;
+    u32_t tail = __atomic_load_n(reading_cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+      reading_complete(reading_cqes[head & reading_cq_mask]);
+      head = head + 1;
+    }
+    __atomic_store_n(reading_cq_head, head, __ATOMIC_RELEASE);
   }
-  return result;
+  if (reading_files[index].state == reading_state_open_failed) {
+    parse_error_opening_file(filename);
+  } else if (reading_files[index].state == reading_state_read_failed) {
+    parse_error_reading_file(filename);
+  } else if (reading_files[index].state == reading_state_unsupported) {
+    parse_map_file(index);
+  }
+}
+
+/* Starts parsing the file with the given index from its beginning. */
+void parse_use_file(u32_t index) {
+  parse_read_buffer = parse_files[index].data;
+  parse_read_buffer_length = parse_files[index].length;
+  current_location = (location_t) { .index = 0 };
+  current_filename = parse_filenames[index];
+  parse_declaration_ordinal = (u64_t) index << 32;
 }
 
-void parse_expression(u8_t depth);
+void parse_stop_using_file() {
+  current_filename = 0;
+  parse_read_buffer = 0;
+  parse_read_buffer_length = 0;
+}
 
-void parse_call_arguments(u8_t depth, location_t name_location, strings_id_t name) {
-  if (depth >= EXPRESSION_PARSING_RECURSION_LIMIT) {
-    log_line("Reached max expression depth.");
-    syscall_exit(1);
+/* Starts a chunk at the current location. */
+void parse_add_chunk(u32_t file) {
+  size_t start = current_location.index;
+  if (parse_chunk_count > 0 && parse_chunks[parse_chunk_count - 1].file == file) {
+    parse_chunks[parse_chunk_count - 1].end = start;
   }
-  parse_fn_signature_t fn = parse_fn_signatures[name];
-  if (fn.exists) {
-    parse_expressions[parse_expression_index] = (expression_t) {
-      .kind = expression_kind_operation,
-      .arity = fn.arity,
-      .data = { .name = name }
-    };
-    parse_expression_index = parse_expression_index + 1;
-    size_t i = 0;
-    while (i < fn.arity) {
-      if (i > 0) {
-        if (parse_exactly(",")) {
-          parse_skip_whitespace();
-        } else {
-          parse_log_current_location();
-          log_line("Expected ',' to separate arguments.");
-          parse_log_current_location_line_with_column_marker();
-          syscall_exit(1);
-        }
-      }
-      parse_expression(depth + 1);
-      parse_skip_whitespace();
-      i = i + 1;
+  parse_chunks[parse_chunk_count] = (parse_chunk_t) {
+    .file = file,
+    .first_ordinal = (u32_t) parse_declaration_ordinal,
+    .start = start,
+    .end = parse_read_buffer_length
+  };
+  parse_chunk_count = parse_chunk_count + 1;
+}
+
+/* Parses the declaration at the current location and emits it, or whatever
+   the command does with it. */
+void parse_next_declaration() {
+  parse_declaration_ordinal = parse_declaration_ordinal + 1;
+  measure_declarations = measure_declarations + 1;
+  /* The kind of a declaration is told by its first character, since what was
+     parsed last is not always the declaration, like when the cache is used. */
+  char first_char = peek_char();
+  declaration_kind_t kind = first_char == 's' ? declaration_kind_struct : first_char == 'c' ? declaration_kind_const : declaration_kind_fn;
+  u64_t counter_values[MEASURE_COUNTER_COUNT];
+  measure_start_declaration(counter_values);
+  if (interface_writing) {
+    parse_declaration();
+    interface_put_declaration();
+  } else if (cache_enabled) {
+    cache_translate_declaration();
+  } else {
+    parse_declaration();
+    emit_declaration();
+  }
+  measure_finish_declaration(counter_values, kind);
+  if (stats_enabled) {
+    stats_note_declaration(kind);
+  }
+}
+
+/* Translates the chunk with the given index. Interface files are loaded
+   instead of being parsed. */
+void parse_chunk(u32_t index) {
+  parse_chunk_t chunk = parse_chunks[index];
+  parse_chunk_index = index;
+  char const* filename = parse_filenames[chunk.file];
+  if (string_ends_with(filename, ".minci")) {
+    interface_load(filename, chunk.file);
+    return;
+  }
+  parse_use_file(chunk.file);
+  current_location.index = chunk.start;
+  parse_declaration_ordinal = parse_declaration_ordinal | chunk.first_ordinal;
+  parse_skip_whitespace();
+  while (current_location.index < chunk.end && peek_char()) {
+    parse_next_declaration();
+    parse_skip_whitespace();
+  }
+  parse_stop_using_file();
+}
+
+char* parse_stream_buffer = 0;
+bool_t parse_stream_ended = false;
+
+/* Reads more of standard input into the window. When the window is getting
+   full, what comes before the current declaration is dropped first, except
+   for the start of the line it is on, which diagnostics show. */
+void parse_stream_read() {
+  size_t keep = current_location.index;
+  if (STREAM_WINDOW_LENGTH - parse_read_buffer_length < STREAM_READ_LENGTH && keep > 0) {
+    size_t start_of_line = keep;
+    while (start_of_line > 0 && parse_stream_buffer[start_of_line - 1] != '\n' && keep - start_of_line < MAX_LINE_LENGTH_FOR_ERRORS) {
+      start_of_line = start_of_line - 1;
     }
-    if (!parse_exactly(")")) {
-      parse_log_current_location();
-      log_string("Expected ')' because the function '");
-      log_string(strings_pointers[name]);
-      log_string("' has arity ");
-      log_size((size_t) fn.arity);
-      log_line(".");
-      parse_log_current_location_line_with_column_marker();
-      syscall_exit(1);
+    if (start_of_line == 0 || parse_stream_buffer[start_of_line - 1] == '\n') {
+      keep = start_of_line;
     }
-  } else {
-    advance_location(&name_location);
-    parse_log_location(name_location);
-    log_string("Unknown function '");
-    log_string(strings_pointers[name]);
-    log_line("'.");
-    parse_log_location_line_with_column_marker(name_location);
-    syscall_exit(1);
+    size_t last_newline = 0;
+    size_t newlines = scan_count_newlines(parse_stream_buffer, 0, keep, &last_newline);
+    parse_stream_lines = parse_stream_lines + newlines;
+    parse_stream_columns = newlines ? keep - last_newline - 1 : parse_stream_columns + keep;
+    copy_bytes(parse_stream_buffer, &parse_stream_buffer[keep], parse_read_buffer_length - keep);
+    work_counts[work_copied] = work_counts[work_copied] + parse_read_buffer_length - keep;
+    parse_read_buffer_length = parse_read_buffer_length - keep;
+    current_location.index = current_location.index - keep;
+  }
+  ensure_array_space(parse_read_buffer_length, STREAM_WINDOW_LENGTH, "stream window");
+  measure_phase_t previous_phase = measure_switch(measure_phase_read);
+  i64_t result = -EINTR;
+  while (result == -EINTR) {
+    result = syscall_read(0, &parse_stream_buffer[parse_read_buffer_length], STREAM_WINDOW_LENGTH - parse_read_buffer_length);
   }
+  measure_switch(previous_phase);
+  if (result < 0) {
+    parse_error_reading_file(current_filename);
+  }
+  parse_stream_ended = result == 0;
+  parse_read_buffer_length = parse_read_buffer_length + result;
+  measure_input_bytes = measure_input_bytes + result;
 }
 
-void parse_non_operator_expression(u8_t depth) {
-  if (depth == EXPRESSION_PARSING_RECURSION_LIMIT) {
-    log_line("Reached max expression depth.");
-    syscall_exit(1);
+/* Returns true if the window holds the whole declaration at the current
+   location, and enough after it to show the line it ends on. Where a
+   declaration ends can be found without parsing it, like when prescanning. */
+bool_t parse_stream_holds_declaration() {
+  char const* data = parse_read_buffer;
+  size_t length = parse_read_buffer_length;
+  size_t index = current_location.index;
+  if (index + 1 >= length) {
+    return false;
   }
-  size_t result_expression_index = parse_expression_index;
-  char c = peek_char();
-  if (parse_identifier_start_chars[(size_t) c]) {
-    location_t name_location = current_location;
-    strings_id_t name = parse_permanent_identifier();
-    parse_skip_whitespace();
-    switch(peek_char()) {
-      case '(':
-        advance_char();
-        parse_call_arguments(depth + 1, name_location, name);
-        break;
-      default:
-        (void) 0;
-        size_t local_variable_index = 0;
-        bool_t found_name = false;
-        parse_local_variable_t variable;
-        expression_kind_t kind;
-        while (local_variable_index < parse_local_variables_index) {
-          variable = parse_local_variables[local_variable_index];
-          if (variable.name == name) {
-            found_name = true;
-            kind = expression_kind_local;
-            break;
-          }
-          local_variable_index = local_variable_index + 1;
-        }
-        if (!found_name && parse_constants[name].exists) {
-          found_name = true;
-          kind = expression_kind_constant;
-        }
-        if (found_name) {
-          parse_expressions[parse_expression_index] = (expression_t) {
-            .kind = kind,
-            .arity = 0,
-            .data = { .name = name }
-          };
-          parse_expression_index = parse_expression_index + 1;
-        } else {
-          /* Advance the identifier location because we saved it at the
-              character _before_ the identifier began. */
-          advance_location(&name_location);
-          parse_log_location(name_location);
-          log_string("Unknown variable '");
-          log_string(strings_pointers[name]);
-          log_line("'.");
-          parse_log_location_line_with_column_marker(name_location);
-          syscall_exit(1);
-        }
-        break;
+  size_t end = index;
+  if (data[index] == 'f' && data[index + 1] == 'n') {
+    end = scan_find(data, index, length, '.', '{');
+    if (end < length && data[end] == '{') {
+      end = scan_find(data, end, length, '}', '}');
     }
-  } else if (parse_digit_chars[(size_t) c]) {
-    do {
-      advance_char();
-    } while (parse_digit_chars[(size_t) peek_char()]);
-    char signedness = parse_char();
-    if (signedness != 'i' && signedness != 'u') {
-      parse_log_current_location();
-      log_line("Expected 'u' or 'i' after digits to specify signedness.");
-      parse_log_current_location_line_with_column_marker();
-      syscall_exit(1);
+  } else if (data[index] == 's') {
+    end = scan_find(data, index, length, ';', ';');
+  } else if (data[index] == 'c') {
+    /* A constant's expression ends with its line. */
+    end = scan_find(data, index, length, '\n', '\n');
+  }
+  return end + 1 + MAX_LINE_LENGTH_FOR_ERRORS <= length;
+}
+
+void parse_stream(u32_t index) {
+  parse_stream_buffer = memory_allocate(STREAM_WINDOW_LENGTH);
+  parse_read_buffer = parse_stream_buffer;
+  parse_read_buffer_length = 0;
+  current_location = (location_t) { .index = 0 };
+  current_filename = parse_filenames[index];
+  parse_declaration_ordinal = (u64_t) index << 32;
+  parse_chunk_index = parse_chunk_count;
+  while (true) {
+    parse_skip_whitespace();
+    while (current_location.index == parse_read_buffer_length && !parse_stream_ended) {
+      parse_stream_read();
+      parse_skip_whitespace();
     }
-    if (!parse_digit_chars[(size_t) parse_char()]) {
-      parse_log_current_location();
-      log_line("Expected digits after signedness to specify size.");
-      parse_log_current_location_line_with_column_marker();
-      syscall_exit(1);
+    while (!parse_stream_ended && !parse_stream_holds_declaration()) {
+      parse_stream_read();
     }
-    while (parse_digit_chars[(size_t) peek_char()]) {
-      advance_char();
+    if (!peek_char()) {
+      break;
     }
-  } else if (c == '(') {
-    advance_char();
-    parse_expressions[parse_expression_index] = (expression_t) {
-      .kind = expression_kind_group,
-      .arity = 1,
-      .data = { .name = 0 }
-    };
-    parse_expression_index = parse_expression_index + 1;
-    parse_expression(depth + 1);
-    if (!parse_exactly(")")) {
-      parse_log_current_location();
-      log_line("Expected ')' to finish group expression.");
-      parse_log_current_location_line_with_column_marker();
-      syscall_exit(1);
+    parse_next_declaration();
+  }
+  parse_stop_using_file();
+}
+
+/* Returns whether standard input is one of the given files, which it can only
+   be as the last one. */
+bool_t parse_find_stream(char const** filenames, u32_t file_count) {
+  bool_t streaming = false;
+  u32_t i = 0;
+  while (i < file_count) {
+    if (string_equal("-", (char*) filenames[i])) {
+      if (i + 1 < file_count) {
+        log_line("Standard input, given as '-', has to be the last file.");
+        syscall_exit(1);
+      }
+      streaming = true;
     }
-  } else {
-    advance_char();
-    parse_log_current_location();
-    log_line("Expected identifier, number literal, or '('.");
-    parse_log_current_location_line_with_column_marker();
-    syscall_exit(1);
+    i = i + 1;
   }
+  return streaming;
+}
+
+/* Declares the constants in the current file, and skips over everything else
+   without parsing it. Array lengths in the other declarations can use
+   constants, so the constants in all of the files are declared first. */
+void parse_prescan_constants() {
   parse_skip_whitespace();
   while (true) {
-    c = peek_char();
-    if (c == '@') {
-      advance_char();
-      parse_skip_whitespace();
-      parse_shift_expressions_starting_at(result_expression_index);
-      type_t type = parse_type();
-      parse_expressions[result_expression_index] = (expression_t) {
-        .kind = expression_kind_cast,
-        .arity = 1,
-        .data = { .type = type }
-      };
-    } else if (c == '`') {
-      parse_shift_expressions_starting_at(result_expression_index);
-      type_t type = parse_type();
-      parse_expressions[result_expression_index] = (expression_t) {
-        .kind = expression_kind_ascription,
-        .arity = 1,
-        .data = { .type = type }
-      };
+    char c = peek_char();
+    parse_declaration_ordinal = parse_declaration_ordinal + 1;
+    if (c == 'c') {
+      parse_declaration();
+    } else if (c == 's') {
+      size_t end = scan_find(parse_read_buffer, current_location.index, parse_read_buffer_length, ';', ';');
+      if (end == parse_read_buffer_length) {
+        return;
+      }
+      current_location.index = end + 1;
+    } else if (c == 'f') {
+      size_t end = cache_fn_declaration_end(current_location.index);
+      if (!end) {
+        return;
+      }
+      current_location.index = end;
     } else {
-      break;
+      /* Anything else is an error, which is reported once the rest of the
+         declarations are prescanned. */
+      return;
     }
+    parse_skip_whitespace();
   }
 }
 
-void parse_expression(u8_t depth) {
-  size_t left_operand_index = parse_expression_index;
-  parse_non_operator_expression(depth + 1);
+/* Declares the structs and functions in the current file, skipping over the
+   function bodies, and splits the file into chunks. */
+void parse_prescan_declarations(u32_t file) {
+  parse_add_chunk(file);
+  size_t chunk_start = 0;
   parse_skip_whitespace();
-  char c = peek_char();
-  if (parse_operator_chars[(size_t) c]) {
-    /* When we see and operator, we need to shift all the previous expressions
-       over by one to make space for the operator's expression to go before all
-       of its operands (like how function expressions work). */
-    strings_id_t operator_name = parse_operator();
-    parse_shift_expressions_starting_at(left_operand_index);
-    parse_expressions[left_operand_index] = (expression_t) {
-      .kind = expression_kind_operator,
-      .arity = 2,
-      .data = (expression_data_t) { .name = operator_name }
-    };
-    parse_expression_index = parse_expression_index + 1;
+  while (peek_char()) {
+    if (current_location.index - chunk_start >= PARSE_CHUNK_LENGTH) {
+      chunk_start = current_location.index;
+      parse_add_chunk(file);
+    }
+    parse_declaration_ordinal = parse_declaration_ordinal + 1;
+    parse_declaration();
     parse_skip_whitespace();
-    parse_non_operator_expression(depth + 1);
   }
 }
 
-void parse_declaration() {
-  char c = parse_char();
-  switch (c) {
-    case 's':
-      if (!parse_exactly("truct")) {
-        parse_error_expected_declaration_start_keyword();
-      }
-      parse_skip_whitespace1();
-      strings_id_t struct_name = parse_permanent_identifier();
-      u16_t first_field_index = struct_fields_index;
-      parse_skip_whitespace();
-      while (true) {
-        strings_id_t field_name = parse_permanent_identifier();
-        parse_skip_whitespace();
-        type_t field_type = parse_type();
-        struct_field_t field = { .name = field_name, .type = field_type };
-        ensure_array_space(struct_fields_index, MAX_STRUCT_FIELDS, "struct_fields");
-        struct_fields[struct_fields_index] = field;
-        struct_fields_index = struct_fields_index + 1;
-        parse_skip_whitespace();
-        switch (parse_char()) {
-          case ',':
-            parse_skip_whitespace();
-            break;
-          case ';':
-            struct_infos[struct_name] = (struct_info_t) {
-              .field_count = struct_fields_index - first_field_index,
-              .first_field_index = first_field_index,
-              .exists = true
-            };
-            return;
-          default:
-            parse_log_current_location();
-            log_line("Expected ',' or ';'.");
-            parse_log_current_location_line_with_column_marker();
-            syscall_exit(1);
-        }
-      }
-      break;
-    case 'c':
-      if (!parse_exactly("onst")) {
-        parse_error_expected_declaration_start_keyword();
-      }
-      parse_skip_whitespace1();
-      strings_id_t const_name = parse_permanent_identifier();
-      parse_skip_whitespace();
-      if (!parse_exactly("=")) {
-        parse_log_current_location();
-        log_line("Expected '='.");
-        parse_log_current_location_line_with_column_marker();
-        syscall_exit(1);
-      }
-      parse_skip_whitespace();
-      u64_t const_value = parse_integer_constant();
-      parse_skip_whitespace1();
-      parse_constants[const_name] = (parse_constant_t) {
-        .exists = true,
-        .value = const_value
-      };
-      break;
-    case 'f':
-      if (!parse_exactly("n")) {
-        parse_error_expected_declaration_start_keyword();
-      }
-      parse_skip_whitespace1();
-      strings_id_t fn_name = parse_permanent_identifier();
-      parse_skip_whitespace();
-      if (!parse_exactly("(")) {
-        parse_log_current_location();
-        log_line("Expected '(' to begin argument list.");
-        parse_log_current_location_line_with_column_marker();
-        syscall_exit(1);
-      }
-      char first_char_of_arg_list = peek_char();
-      parse_fn_signature_t signature = {0};
-      signature.exists = true;
-      parse_local_variables_index = 0;
-      if (first_char_of_arg_list != ')') {
-        while (true) {
-          parse_local_variable_t variable = {0};
-          variable.name = parse_permanent_identifier();
-          parse_skip_whitespace();
-          variable.type = parse_type();
-          signature.args[signature.arity] = variable;
-          parse_local_variables[signature.arity] = variable;
-          signature.arity = signature.arity + 1;
-          parse_local_variables_index = signature.arity;
-          parse_skip_whitespace();
-          switch (parse_char()) {
-            case ',':
-              parse_skip_whitespace();
-              break;
-            case ')':
-              goto finished_arg_list;
-              break;
-            default:
-              parse_log_current_location();
-              log_line("Expected ',' or ')'.");
-              parse_log_current_location_line_with_column_marker();
-              syscall_exit(1);
-              break;
-          }
-        }
-      } else {
-        advance_char();
-      }
-finished_arg_list:
-      parse_skip_whitespace();
-      if (peek_char() == '`') {
-        signature.return_type = parse_type();
-        parse_skip_whitespace();
-      } else {
-        signature.return_type.base = builtin_strings_void;
-      }
-      parse_fn_signatures[fn_name] = signature;
-      c = peek_char();
-      if (c == '{') {
-        advance_char();
-        while (true) {
-          parse_skip_whitespace();
-          char c = peek_char();
-          if (parse_identifier_start_chars[(size_t) c]) {
-            location_t name_location = current_location;
-            strings_id_t name = parse_permanent_identifier();
-            if (name == builtin_strings_if) {
-              parse_skip_whitespace();
-              parse_expression(0);
-            } else if (name == builtin_strings_else) {
-            } else if (name == builtin_strings_end) {
-            } else if (name == builtin_strings_switch) {
-              parse_skip_whitespace();
-              parse_expression(0);
-            } else if (name == builtin_strings_case) {
-              parse_skip_whitespace();
-              parse_integer_constant();
-              parse_skip_whitespace1();
-            } else if (name == builtin_strings_while) {
-              parse_skip_whitespace();
-              parse_expression(0);
-            } else if (name == builtin_strings_return) {
-              parse_skip_whitespace();
-              parse_expression(0);
-            } else {
-              parse_skip_whitespace();
-              char c = peek_char();
-              if (c == '=') {
-                advance_char();
-                parse_skip_whitespace();
-                parse_expression(0);
-                parse_local_variables[parse_local_variables_index] = (parse_local_variable_t) {
-                  .name = name,
-                  .type = {0}
-                };
-                parse_local_variables_index = parse_local_variables_index + 1;
-              } else if (c == '(') {
-                advance_char();
-                parse_call_arguments(0, name_location, name);
-              } else {
-                parse_log_current_location();
-                log_line("Expected statement or '}'.");
-                parse_log_current_location_line_with_column_marker();
-                syscall_exit(1);
-              }
-            }
-          } else if (c == '}') {
-            advance_char();
-            goto finished_fn_body;
-          } else {
-            advance_char();
-            parse_log_current_location();
-            log_line("Expected statement or '}'.");
-            parse_log_current_location_line_with_column_marker();
-            syscall_exit(1);
-          }
-        }
-      } else if (c == '.') {
-        /* We already saved the function signature, so there is nothing else to
-           do except move past the dot. */
-        advance_char();
+void parse_prescan(char const** filenames, u32_t file_count) {
+  parse_filenames = filenames;
+  size_t kind = 0;
+  while (kind < 3) {
+    parse_declaration_ordinals[kind] = memory_allocate(limit_strings * sizeof(u64_t));
+    parse_declaration_ends[kind] = memory_allocate(limit_strings * sizeof(size_t));
+    kind = kind + 1;
+  }
+  parse_files = memory_allocate(file_count * sizeof(parse_file_t));
+  parse_prescanning = true;
+  reading_start(file_count);
+  size_t total_length = 0;
+  u32_t i = 0;
+  while (i < file_count) {
+    if (string_ends_with(filenames[i], ".minci")) {
+      interface_load(filenames[i], i);
+    } else if (!parse_file_is_stream(i)) {
+      measure_phase_t previous_phase = measure_switch(measure_phase_read);
+      if (reading_enabled) {
+        reading_wait(i);
       } else {
-        parse_log_current_location();
-        log_line("Expected '.' or '{' after argument list.");
-        parse_log_current_location_line_with_column_marker();
-        syscall_exit(1);
+        parse_map_file(i);
       }
-finished_fn_body:
-      break;
-    default:
-      parse_error_expected_declaration_start_keyword();
-      break;
+      measure_switch(previous_phase);
+      total_length = total_length + parse_files[i].length;
+      parse_use_file(i);
+      parse_prescan_constants();
+      parse_stop_using_file();
+    }
+    i = i + 1;
+  }
+  reading_finish();
+  measure_input_bytes = total_length;
+  /* Each chunk after the first one of a file starts at least
+     PARSE_CHUNK_LENGTH bytes after the one before it. */
+  parse_chunks = memory_allocate((file_count + total_length / PARSE_CHUNK_LENGTH) * sizeof(parse_chunk_t));
+  i = 0;
+  while (i < file_count) {
+    if (string_ends_with(filenames[i], ".minci")) {
+      parse_add_chunk(i);
+    } else if (!parse_file_is_stream(i)) {
+      parse_use_file(i);
+      parse_prescan_declarations(i);
+      parse_stop_using_file();
+    }
+    i = i + 1;
   }
+  parse_prescanning = false;
 }
 
-void parse_file(char const* filename) {
-  i32_t fd = syscall_open(filename, O_RDONLY, 0);
-  if (fd >= 0) {
-    bool_t reached_end_of_file = false;
-    while (true) {
-      size_t remaining_capacity = PARSE_READ_BUFFER_CAPACITY - parse_read_buffer_length;
-      if (remaining_capacity == 0) {
-        break;
-      }
-      i64_t read_result = syscall_read(fd, &parse_read_buffer[parse_read_buffer_length], remaining_capacity);
-      if (read_result > 0) {
-        parse_read_buffer_length = parse_read_buffer_length + read_result;
-      } else if (read_result == 0) {
-        reached_end_of_file = true;
-        break;
-      } else {
-        log_string("Got unix error code while trying to read file \"");
-        log_string(filename);
-        log_line("\".");
-        syscall_exit(1);
-      }
+/* Allocates the large arrays that are shared between threads and whose sizes
+   depend on the limits. */
+void limits_allocate_arrays() {
+  strings_data = memory_allocate_dense(limit_strings_data);
+  strings_pointers = memory_allocate_dense(limit_strings * sizeof(char*));
+  strings_lengths = memory_allocate_dense(limit_strings * sizeof(u32_t));
+  size_t slot_count = 1;
+  while (slot_count < 2 * limit_strings) {
+    slot_count = 2 * slot_count;
+  }
+  strings_slots = memory_allocate(slot_count * sizeof(u64_t));
+  strings_slots_mask = slot_count - 1;
+  size_t id = 0;
+  while (id < BUILTIN_STRINGS_COUNT) {
+    strings_pointers[id] = builtin_strings_words[id];
+    strings_lengths[id] = builtin_strings_lengths[id];
+    id = id + 1;
+  }
+  strings_pointers_count = BUILTIN_STRINGS_COUNT;
+  struct_infos = memory_allocate_dense(limit_strings * sizeof(struct_info_t));
+  parse_fn_signatures = memory_allocate_dense(limit_strings * sizeof(parse_fn_signature_t));
+  parse_fn_signature_indexes = memory_allocate(limit_strings * sizeof(u32_t));
+  parse_fn_arguments = memory_allocate_dense(limit_fn_arguments * sizeof(parse_local_variable_t));
+  parse_constants = memory_allocate(limit_strings * sizeof(parse_constant_t));
+  cache_string_table = memory_allocate(limit_strings * sizeof(strings_id_t));
+  cache_string_table_indexes = memory_allocate(limit_strings * sizeof(u32_t));
+  cache_dependencies = memory_allocate(2 * limit_strings * sizeof(cache_dependency_t));
+  cache_dependency_marks[0] = memory_allocate(limit_strings * sizeof(u32_t));
+  cache_dependency_marks[1] = memory_allocate(limit_strings * sizeof(u32_t));
+}
+
+/* Allocates the large arrays of the calling thread. */
+void threads_allocate_state() {
+  parse_local_bindings = memory_allocate(limit_strings * sizeof(u32_t));
+  parse_expressions = memory_allocate_dense(limit_expressions * sizeof(expression_t));
+  parse_frames = memory_allocate(limit_expression_nesting * sizeof(parse_frame_t));
+  parse_pending_operators = memory_allocate(limit_expression_nesting * sizeof(parse_pending_operator_t));
+  constant_values = memory_allocate(limit_expressions * sizeof(constant_value_t));
+  parse_statements = memory_allocate(MAX_STATEMENTS * sizeof(statement_t));
+  parse_fields = memory_allocate(MAX_STRUCT_FIELDS * sizeof(struct_field_t));
+  emit_work = memory_allocate_dense(limit_expressions * sizeof(emit_work_t));
+  cache_string_ids = memory_allocate(limit_strings * sizeof(strings_id_t));
+  parse_forward_calls = memory_allocate(limit_strings * sizeof(strings_id_t));
+  parse_prototype_chunks = memory_allocate(limit_strings * sizeof(u32_t));
+}
+
+/* A new thread needs its own copy of the thread-local variables, starting out
+   with their initial values. The ELF program headers say where those values
+   are, and the kernel tells the program where its headers are through the
+   auxiliary vector, which follows the environment on the initial stack. */
+typedef struct elf_program_header_t {
+  u32_t type;
+  u32_t flags;
+  u64_t offset;
+  u64_t virtual_address;
+  u64_t physical_address;
+  u64_t file_size;
+  u64_t memory_size;
+  u64_t alignment;
+} elf_program_header_t;
+
+#define AT_PHDR 3
+#define AT_PHNUM 5
+#define PT_PHDR 6
+#define PT_TLS 7
+
+u8_t const* threads_tls_image = 0;
+size_t threads_tls_image_length = 0;
+size_t threads_tls_length = 0;
+size_t threads_tls_alignment = 1;
+
+void threads_find_tls(char** argv) {
+  char** environment = argv;
+  while (*environment) {
+    environment = environment + 1;
+  }
+  environment = environment + 1;
+  while (*environment) {
+    environment = environment + 1;
+  }
+  u64_t const* auxiliary = (u64_t const*) (environment + 1);
+  elf_program_header_t const* headers = 0;
+  size_t header_count = 0;
+  while (auxiliary[0]) {
+    if (auxiliary[0] == AT_PHDR) {
+      headers = (elf_program_header_t const*) auxiliary[1];
+    } else if (auxiliary[0] == AT_PHNUM) {
+      header_count = auxiliary[1];
     }
-    if (!reached_end_of_file) {
-      char single_char[1];
-      i64_t read_result = syscall_read(fd, single_char, 1);
-      if (read_result > 0) {
-        log_string("Reached 10 MB file size limit while reading file \"");
-        log_string(filename);
-        log_line("\".");
-        syscall_exit(1);
-      } else if (read_result < 0) {
-        log_string("Got unix error code while trying to read file \"");
-        log_string(filename);
-        log_line("\".");
-        syscall_exit(1);
-      }
+    auxiliary = auxiliary + 2;
+  }
+  /* The program may be loaded at a different address than it was linked at,
+     which the header describing the headers themselves reveals. */
+  u64_t load_offset = 0;
+  size_t i = 0;
+  while (i < header_count) {
+    if (headers[i].type == PT_PHDR) {
+      load_offset = (u64_t) headers - headers[i].virtual_address;
     }
-    current_filename = filename;
-    parse_skip_whitespace();
-    while (peek_char()) {
-      parse_declaration();
-      parse_skip_whitespace();
+    i = i + 1;
+  }
+  i = 0;
+  while (i < header_count) {
+    if (headers[i].type == PT_TLS) {
+      threads_tls_image = (u8_t const*) (load_offset + headers[i].virtual_address);
+      threads_tls_image_length = headers[i].file_size;
+      threads_tls_length = headers[i].memory_size;
+      if (headers[i].alignment > 1) {
+        threads_tls_alignment = headers[i].alignment;
+      }
     }
-    current_filename = 0;
-  } else {
-    log_string("Got unix error code while trying to open \"");
-    log_string(filename);
-    log_line("\".");
+    i = i + 1;
+  }
+}
+
+/* On x86-64 the thread-local variables of the program end right below the
+   address the thread pointer holds, and the first word at that address must
+   point to itself. The block for them takes up this many bytes, with room to
+   align the thread pointer. */
+size_t threads_tls_block_length() {
+  size_t alignment = threads_tls_alignment < 64 ? 64 : threads_tls_alignment;
+  size_t tls_offset = (threads_tls_length + threads_tls_alignment - 1) & ~(threads_tls_alignment - 1);
+  return tls_offset + 2 * alignment;
+}
+
+/* Fills in a block of threads_tls_block_length bytes with the initial values
+   of the thread-local variables, and returns the thread pointer for it. */
+u64_t threads_init_tls(u8_t* block) {
+  size_t alignment = threads_tls_alignment < 64 ? 64 : threads_tls_alignment;
+  size_t tls_offset = (threads_tls_length + threads_tls_alignment - 1) & ~(threads_tls_alignment - 1);
+  u64_t thread_pointer = ((u64_t) block + tls_offset + alignment - 1) & ~(alignment - 1);
+  copy_bytes((u8_t*) thread_pointer - tls_offset, threads_tls_image, threads_tls_image_length);
+  *(u64_t*) thread_pointer = thread_pointer;
+  return thread_pointer;
+}
+
+/* Gives the main thread its thread-local variables. A dynamically linked
+   program already has them from the loader, but a statically linked one
+   doesn't, so this has to come before anything thread-local is touched. */
+void threads_init_main(char** argv) {
+  threads_find_tls(argv);
+  u64_t thread_pointer = threads_init_tls(memory_allocate(threads_tls_block_length()));
+  if (syscall_arch_prctl(ARCH_SET_FS, thread_pointer) < 0) {
+    log_line("Got unix error code while setting up thread-local variables.");
+    syscall_exit(1);
+  }
+}
+
+void threads_spawn(i32_t (*function)(void*)) {
+  u8_t* memory = memory_allocate(THREAD_STACK_SIZE + threads_tls_block_length());
+  u64_t thread_pointer = threads_init_tls(memory + THREAD_STACK_SIZE);
+  if (thread_spawn(memory + THREAD_STACK_SIZE, (void*) thread_pointer, function, 0) < 0) {
+    log_line("Got unix error code while starting a thread.");
     syscall_exit(1);
   }
 }
 
+typedef struct threads_output_t {
+  char* data;
+  size_t length;
+  size_t capacity;
+} threads_output_t;
+
+threads_output_t* threads_outputs = 0;
+u32_t threads_next_chunk = 0;
+/* The number of threads that ran out of chunks, after which they only
+   return. */
+u32_t threads_exited = 0;
+
+i32_t threads_translate_chunks(void* unused) {
+  (void) unused;
+  threads_allocate_state();
+  measure_start_thread();
+  while (true) {
+    u32_t index = __atomic_fetch_add(&threads_next_chunk, 1, __ATOMIC_RELAXED);
+    if (index >= threads_chunk_count) {
+      measure_finish_thread();
+      stats_finish_thread();
+      __atomic_fetch_add(&threads_exited, 1, __ATOMIC_RELEASE);
+      syscall_futex(&threads_exited, FUTEX_WAKE_PRIVATE, 1);
+      return 0;
+    }
+    threads_chunk = index + 1;
+    emit_start_buffer();
+    parse_chunk(index);
+    threads_outputs[index] = (threads_output_t) {
+      .data = emit_buffer,
+      .length = emit_buffer_length,
+      .capacity = emit_buffer_capacity
+    };
+    threads_finish_chunk(index);
+    threads_chunk = 0;
+  }
+}
+
+/* Translates the chunks with the given number of threads, and writes out the
+   output of each chunk as soon as it and the chunks before it are done. */
+void threads_translate(u32_t thread_count) {
+  threads_chunk_count = parse_chunk_count;
+  threads_done = memory_allocate(parse_chunk_count);
+  threads_outputs = memory_allocate(parse_chunk_count * sizeof(threads_output_t));
+  u32_t i = 0;
+  while (i < thread_count && i < parse_chunk_count) {
+    threads_spawn(threads_translate_chunks);
+    i = i + 1;
+  }
+  u32_t spawned = i;
+  i = 0;
+  while (i < parse_chunk_count) {
+    u32_t prefix = __atomic_load_n(&threads_done_prefix, __ATOMIC_ACQUIRE);
+    if (prefix <= i) {
+      syscall_futex(&threads_done_prefix, FUTEX_WAIT_PRIVATE, prefix);
+      continue;
+    }
+    threads_output_t output = threads_outputs[i];
+    emit_write(output.data, output.length);
+    syscall_munmap(output.data, output.capacity);
+    i = i + 1;
+  }
+  /* The threads add their timings for '-t' on their way out. */
+  while (true) {
+    u32_t exited = __atomic_load_n(&threads_exited, __ATOMIC_ACQUIRE);
+    if (exited == spawned) {
+      break;
+    }
+    syscall_futex(&threads_exited, FUTEX_WAIT_PRIVATE, exited);
+  }
+}
+
 i32_t main(i32_t argc, char* argv[]) {
+  threads_init_main(argv);
   if (argc < 2) {
     log_line("Usage: <exe> command file...");
     log_line("Commands:");
     log_indent();
     log_line("translate   Read the provided Minor C source files and send equivalent C code to stdout.");
+    log_line("interface   Write the declarations in the provided Minor C source files to an");
+    log_line("            interface file, which can be given to translate in place of the");
+    log_line("            sources to use the declarations without parsing them.");
     log_line("sizes       Print the sizes of compiler-internal data types.");
     log_dedent();
+    log_line("Files whose names end in .minci are read as interface files.");
+    log_line("Standard input, given as the last file name -, is read as it arrives.");
+    log_line("Declarations in it have to come before their use.");
+    log_line("Options for translate:");
+    log_indent();
+    log_line("-o file     Write the C code to the given file instead of stdout.");
+    log_line("-c file     Reuse the translations of unchanged functions from the given");
+    log_line("            cache file, and update it.");
+    log_line("-j count    Translate the files with the given number of threads. Declarations");
+    log_line("            of the same name in different files must agree, and '-c' can't");
+    log_line("            be used.");
+    log_line("-l limit=n  Change one of the limits below, to translate bigger programs or to");
+    log_line("            use less address space. Can be given more than once.");
+    log_line("-t          Print a table of the seconds spent reading, lexing, interning");
+    log_line("            strings, parsing and emitting, with the megabytes of input and");
+    log_line("            the declarations translated per second, to standard error.");
+    log_line("            With '-j', the phases add up the time of all the threads.");
+    log_line("-p          Print tables of the cycles, instructions, cache misses, branch");
+    log_line("            misses and page faults counted in each phase and while");
+    log_line("            translating each kind of declaration, leaving out the counters");
+    log_line("            that the machine doesn't have.");
+    log_line("-s          Print how much of each limit was used, the declarations that");
+    log_line("            needed the most expressions and local variables, the number of");
+    log_line("            declarations of each kind, and how many probes finding each");
+    log_line("            string in the hashmap takes, and counts of the work done.");
+    log_dedent();
+    log_line("Options for interface:");
+    log_indent();
+    log_line("-o file     Write the interface to the given file. This option is required.");
+    log_line("-l limit=n  Change one of the limits below.");
+    log_dedent();
+    log_line("Limits:");
+    log_indent();
+    log_line("strings=1048576        Distinct names and literals in all of the input.");
+    log_line("strings-data=104857600 Bytes taken up by those.");
+    log_line("expressions=10485760   Expressions in one function.");
+    log_line("nesting=1048576        Depth of nested expressions in one function.");
+    log_line("arguments=10485760     Arguments of all the function declarations.");
+    log_line("cache-entries=1048576  Entries loaded from the file given with '-c'.");
+    log_dedent();
     return 0;
   }
   char* command = argv[1];
   if (string_equal("translate", command)) {
-    if (argc < 3) {
+    char const* output_filename = 0;
+    char const* cache_filename = 0;
+    u32_t thread_count = 0;
+    bool_t timing = false;
+    bool_t profiling = false;
+    bool_t statistics = false;
+    char const** filenames = memory_allocate(argc * sizeof(char const*));
+    u32_t file_count = 0;
+    i32_t arg_index = 2;
+    while (arg_index < argc) {
+      if (string_equal("-o", argv[arg_index])) {
+        if (arg_index + 1 == argc) {
+          log_line("Expected a file name after '-o'.");
+          syscall_exit(1);
+        }
+        output_filename = argv[arg_index + 1];
+        arg_index = arg_index + 2;
+      } else if (string_equal("-c", argv[arg_index])) {
+        if (arg_index + 1 == argc) {
+          log_line("Expected a file name after '-c'.");
+          syscall_exit(1);
+        }
+        cache_filename = argv[arg_index + 1];
+        arg_index = arg_index + 2;
+      } else if (string_equal("-l", argv[arg_index])) {
+        limits_set(arg_index + 1 < argc ? argv[arg_index + 1] : "");
+        arg_index = arg_index + 2;
+      } else if (string_equal("-j", argv[arg_index])) {
+        char const* digits = arg_index + 1 < argc ? argv[arg_index + 1] : "";
+        size_t i = 0;
+        while (digits[i] >= '0' && digits[i] <= '9' && thread_count <= MAX_THREADS) {
+          thread_count = thread_count * 10 + digits[i] - '0';
+          i = i + 1;
+        }
+        if (digits[i] || thread_count == 0 || thread_count > MAX_THREADS) {
+          log_line("Expected a number of threads from 1 to 256 after '-j'.");
+          syscall_exit(1);
+        }
+        arg_index = arg_index + 2;
+      } else if (string_equal("-t", argv[arg_index])) {
+        timing = true;
+        arg_index = arg_index + 1;
+      } else if (string_equal("-p", argv[arg_index])) {
+        profiling = true;
+        arg_index = arg_index + 1;
+      } else if (string_equal("-s", argv[arg_index])) {
+        statistics = true;
+        arg_index = arg_index + 1;
+      } else {
+        filenames[file_count] = argv[arg_index];
+        file_count = file_count + 1;
+        arg_index = arg_index + 1;
+      }
+    }
+    if (file_count == 0) {
       log_line("No source files provided.");
       syscall_exit(1);
     }
-    parse_init_char_tables();
-    builtin_strings_init();
+    if (cache_filename && thread_count) {
+      log_line("The '-c' and '-j' options can't be used together.");
+      syscall_exit(1);
+    }
+    bool_t streaming = parse_find_stream(filenames, file_count);
+    if (streaming && thread_count) {
+      log_line("Standard input, given as '-', can't be translated with '-j'.");
+      syscall_exit(1);
+    }
+    if (output_filename) {
+      emit_fd = syscall_open(output_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (emit_fd < 0) {
+        log_string("Got unix error code while trying to open \"");
+        log_string(output_filename);
+        log_line("\".");
+        syscall_exit(1);
+      }
+    }
+    scan_init();
+    limits_allocate_arrays();
+    threads_allocate_state();
+    emit_start_buffer();
+    threads_enabled = thread_count != 0;
+    if (timing || profiling) {
+      measure_start(timing, profiling);
+    }
+    stats_enabled = statistics;
+    parse_prescan(filenames, file_count);
+    if (cache_filename) {
+      cache_open(cache_filename);
+    }
+    emit_preamble();
+    if (thread_count) {
+      emit_flush();
+      threads_translate(thread_count);
+    } else {
+      u32_t i = 0;
+      while (i < parse_chunk_count) {
+        parse_chunk(i);
+        i = i + 1;
+      }
+    }
+    if (streaming) {
+      parse_stream(file_count - 1);
+    }
+    emit_flush();
+    if (cache_filename) {
+      cache_close();
+    }
+    if (timing || profiling) {
+      measure_report();
+    }
+    if (statistics) {
+      stats_report();
+    }
+  } else if (string_equal("interface", command)) {
+    char const* output_filename = 0;
+    char const** filenames = memory_allocate(argc * sizeof(char const*));
+    u32_t file_count = 0;
     i32_t arg_index = 2;
     while (arg_index < argc) {
-      parse_file(argv[arg_index]);
-      arg_index = arg_index + 1;
+      if (string_equal("-o", argv[arg_index])) {
+        if (arg_index + 1 == argc) {
+          log_line("Expected a file name after '-o'.");
+          syscall_exit(1);
+        }
+        output_filename = argv[arg_index + 1];
+        arg_index = arg_index + 2;
+      } else if (string_equal("-l", argv[arg_index])) {
+        limits_set(arg_index + 1 < argc ? argv[arg_index + 1] : "");
+        arg_index = arg_index + 2;
+      } else {
+        filenames[file_count] = argv[arg_index];
+        file_count = file_count + 1;
+        arg_index = arg_index + 1;
+      }
+    }
+    if (file_count == 0) {
+      log_line("No source files provided.");
+      syscall_exit(1);
+    }
+    if (!output_filename) {
+      log_line("Expected the interface file to be given with '-o'.");
+      syscall_exit(1);
+    }
+    bool_t streaming = parse_find_stream(filenames, file_count);
+    scan_init();
+    limits_allocate_arrays();
+    threads_allocate_state();
+    emit_start_buffer();
+    parse_prescan(filenames, file_count);
+    interface_open(output_filename);
+    u32_t i = 0;
+    while (i < parse_chunk_count) {
+      parse_chunk(i);
+      i = i + 1;
+    }
+    if (streaming) {
+      parse_stream(file_count - 1);
     }
+    interface_close();
   } else if (string_equal("sizes", command)) {
     log_string("type_t: ");
     log_size(sizeof(type_t));
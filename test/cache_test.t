@@ -0,0 +1,81 @@
+Translations of functions are saved to the cache file given with '-c', and a
+later run reuses them for any function whose bytes are unchanged.
+
+  $ translate() { $MAIN translate "$@" -o t.c && tail -n +13 t.c; }
+
+  $ cat > t.minc <<\.
+  > const limit = 10
+  > fn next(x `u32) `u32.
+  > fn f(x `u32) `u32 {
+  >   y = next(x)
+  >   return y + limit@`u32
+  > }
+  > .
+
+  $ translate t.minc -c t.cache
+  u32 next(u32 x);
+  
+  u32 f(u32 x) {
+    u32 y;
+    y = next(x);
+    return y + (u32)10;
+  }
+
+  $ cp t.c cold.c
+  $ translate t.minc -c t.cache > /dev/null
+  $ cmp cold.c t.c
+
+The cached code is used as is, which shows up if the cache is tampered with.
+
+  $ sed -i 's/return y + (u32)/RETURN y + (u32)/' t.cache
+  $ translate t.minc -c t.cache | grep RETURN
+    RETURN y + (u32)10;
+
+The bytes of the function are saved with its entry and compared too, so an
+entry whose hash and length match by accident is not used. Changing them in
+the file stands in for such a collision.
+
+  $ cp t.cache collision.cache
+  $ sed -i 's/return y + limit/return y - limit/' collision.cache
+  $ translate t.minc -c collision.cache | grep -i return
+    return y + (u32)10;
+
+A function is translated again when a constant it uses changes value.
+
+  $ sed -i 's/limit = 10/limit = 11/' t.minc
+  $ translate t.minc -c t.cache | grep return
+    return y + (u32)11;
+
+Or when the signature of a function it calls changes.
+
+  $ sed -i 's/fn next(x `u32) `u32./fn next(x `u32) `u64./' t.minc
+  $ translate t.minc -c t.cache | grep -A 1 'u32 f'
+  u32 f(u32 x) {
+    u64 y;
+
+Cache files that are not valid are ignored and replaced.
+
+  $ echo 'not a cache' > t.cache
+  $ translate t.minc -c t.cache > /dev/null
+  $ head -c 8 t.cache
+  MINCACHE (no-eol)
+  $ translate t.minc -c t.cache | grep -c next
+  2
+
+At most as many entries as '-l cache-entries' allows are loaded from the
+file, and the functions past them are translated again.
+
+  $ cat > two.minc <<\.
+  > fn f() `u32 {
+  >   return 1u32
+  > }
+  > fn g() `u32 {
+  >   return 2u32
+  > }
+  > .
+  $ translate two.minc -c two.cache > /dev/null
+  $ sed -i 's/return (u32)/RETURN (u32)/' two.cache
+  $ translate two.minc -c two.cache -l cache-entries=1 | grep -c RETURN
+  1
+  $ translate two.minc -c two.cache | grep -c RETURN
+  1
@@ -4,7 +4,44 @@ Running the program with no argument yields some help text.
   Usage: <exe> command file...
   Commands:
     translate   Read the provided Minor C source files and send equivalent C code to stdout.
+    interface   Write the declarations in the provided Minor C source files to an
+                interface file, which can be given to translate in place of the
+                sources to use the declarations without parsing them.
     sizes       Print the sizes of compiler-internal data types.
+  Files whose names end in .minci are read as interface files.
+  Standard input, given as the last file name -, is read as it arrives.
+  Declarations in it have to come before their use.
+  Options for translate:
+    -o file     Write the C code to the given file instead of stdout.
+    -c file     Reuse the translations of unchanged functions from the given
+                cache file, and update it.
+    -j count    Translate the files with the given number of threads. Declarations
+                of the same name in different files must agree, and '-c' can't
+                be used.
+    -l limit=n  Change one of the limits below, to translate bigger programs or to
+                use less address space. Can be given more than once.
+    -t          Print a table of the seconds spent reading, lexing, interning
+                strings, parsing and emitting, with the megabytes of input and
+                the declarations translated per second, to standard error.
+                With '-j', the phases add up the time of all the threads.
+    -p          Print tables of the cycles, instructions, cache misses, branch
+                misses and page faults counted in each phase and while
+                translating each kind of declaration, leaving out the counters
+                that the machine doesn't have.
+    -s          Print how much of each limit was used, the declarations that
+                needed the most expressions and local variables, the number of
+                declarations of each kind, and how many probes finding each
+                string in the hashmap takes, and counts of the work done.
+  Options for interface:
+    -o file     Write the interface to the given file. This option is required.
+    -l limit=n  Change one of the limits below.
+  Limits:
+    strings=1048576        Distinct names and literals in all of the input.
+    strings-data=104857600 Bytes taken up by those.
+    expressions=10485760   Expressions in one function.
+    nesting=1048576        Depth of nested expressions in one function.
+    arguments=10485760     Arguments of all the function declarations.
+    cache-entries=1048576  Entries loaded from the file given with '-c'.
 
 An error message is displayed when the specified command is unrecognized.
 
@@ -25,3 +62,186 @@ Passing multiple files works.
   > .
 
   $ $MAIN translate fns1.minc fns2.minc
+  typedef signed char i8;
+  typedef unsigned char u8;
+  typedef signed short i16;
+  typedef unsigned short u16;
+  typedef signed int i32;
+  typedef unsigned int u32;
+  typedef signed long i64;
+  typedef unsigned long u64;
+  typedef unsigned long size;
+  typedef float f32;
+  typedef double f64;
+  
+  void f(i32 a, i32 b) {
+  }
+  
+  void g(f32 x, f64 y) {
+  }
+  
+  void x(i32 a, i32 b) {
+  }
+  
+  void y(void) {
+  }
+
+Empty files are accepted, and locations in diagnostics restart at the top of
+each file.
+
+  $ : > empty.minc
+
+  $ printf 'fn f() {\n' > unterminated.minc
+
+  $ $MAIN translate fns1.minc empty.minc unterminated.minc
+  unterminated.minc:2:2: Expected statement or '}'.
+  2 | <end-of-file>
+      ^
+  [1]
+
+Several files are read at once, but a file that can't be opened or read is
+reported only after the files before it have been checked.
+
+  $ echo 'const width = x' > badconst.minc
+  $ $MAIN translate fns1.minc badconst.minc missing.minc
+  badconst.minc:1:16: Unknown integer constant 'x'.
+  1 | const width = x
+                    ^
+  [1]
+
+  $ $MAIN translate fns1.minc missing.minc unterminated.minc
+  Got unix error code while trying to open "missing.minc".
+  [1]
+
+  $ mkdir directory.minc
+  $ $MAIN translate fns1.minc directory.minc
+  Got unix error code while trying to read file "directory.minc".
+  [1]
+
+Standard input is translated as it arrives when it is given as '-', after
+any other files. It can use what those files declare, but its own
+declarations have to come before their use.
+
+  $ printf 'fn h() {\n  f(1i32, 2i32)\n}\n' | $MAIN translate fns1.minc - | tail -n 3
+  void h(void) {
+    f((i32)1, (i32)2);
+  }
+
+  $ printf 'fn h() `i32 {\n  return k()\n}\nfn k() `i32.\n' | $MAIN translate -
+  -:2:11: Unknown function 'k'.
+  2 |   return k()
+               ^
+  [1]
+
+A constant is only parsed once its whole line has arrived.
+
+  $ (awk 'BEGIN { printf "const a = 1"; for (i = 0; i < 60; i++) printf " + 1" }'; sleep 0.2; printf ' + 1000\nfn f() `u64 {\n  return a\n}\n') | $MAIN translate - | tail -n 3
+  u64 f(void) {
+    return 1061;
+  }
+
+Lines are counted across the whole input, even though only a window of it is
+kept.
+
+  $ awk 'BEGIN { for (i = 0; i < 700000; i++) printf "fn f%d() `i32 {\n  return 0i32\n}\n", i % 1000; print "fn bad() `i32 {\n  return missing()\n}" }' | $MAIN translate - > /dev/null
+  -:2100002:11: Unknown function 'missing'.
+  2100002 |   return missing()
+                     ^
+  [1]
+
+  $ echo | $MAIN translate - fns1.minc
+  Standard input, given as '-', has to be the last file.
+  [1]
+  $ echo | $MAIN translate -j 2 fns1.minc -
+  Standard input, given as '-', can't be translated with '-j'.
+  [1]
+
+Programs are not limited to 65536 distinct names.
+
+  $ seq 70000 | sed 's/.*/fn f&()./' > many.minc
+
+  $ $MAIN translate many.minc > many.c && tail -n 1 many.c
+  void f70000(void);
+
+Limits on the size of the input can be changed with '-l'.
+
+  $ $MAIN translate -l strings=60000 many.minc > /dev/null
+  The compiler has reached the capacity of its 'strings_pointers' array and cannot continue.
+  [1]
+  $ printf 'fn sum() `i32 {\n  return 1i32 + 2i32\n}\n' > sum.minc
+  $ $MAIN translate -l expressions=2 sum.minc > /dev/null
+  The compiler has reached the capacity of its 'parse_expressions' array and cannot continue.
+  [1]
+  $ $MAIN translate -l expressions=3 -l strings=1000 sum.minc | tail -n 3
+  i32 sum(void) {
+    return (i32)1 + (i32)2;
+  }
+  $ $MAIN translate -l strings 10 fns1.minc
+  Expected strings, strings-data, expressions, nesting, arguments or cache-entries, then '=' and a count, after '-l'.
+  [1]
+  $ $MAIN translate -l nesting=0 fns1.minc
+  Expected a limit on nesting from 1 to 2147483648.
+  [1]
+  $ $MAIN translate -l strings=39 fns1.minc
+  Expected a limit on strings from 40 to 2147483648.
+  [1]
+  $ $MAIN interface -l strings=1 -o fns1.minci fns1.minc
+  Expected a limit on strings from 40 to 2147483648.
+  [1]
+
+With '-t', a table of the time spent in each phase is printed to standard
+error, as tab-separated columns, after the output is written. The rates are
+of the whole input, so they can be compared between phases.
+
+  $ $MAIN translate -t many.minc 2>&1 > /dev/null | cut -f 1
+  phase
+  read
+  lex
+  intern
+  parse
+  emit
+  total
+  $ $MAIN translate -t -j 2 many.minc 2>&1 > /dev/null | awk -F '\t' '{ print NF }' | uniq -c
+        7 4
+
+With '-p', tables of hardware counters are printed instead, for each phase and
+for each kind of declaration. Which counters there are depends on the machine.
+
+  $ $MAIN translate -p many.minc 2> counters.txt | cmp - many.c
+  $ grep -c -e '^fn ' -e '^No performance counters' counters.txt
+  1
+
+With '-s', statistics about the use of the limits and the strings hashmap are
+printed to standard error.
+
+  $ cat > stats.minc <<\.
+  > const size = 4
+  > struct point x `i32, y `i32[size];
+  > fn small(a `i32) `i32 {
+  >   return a
+  > }
+  > fn big(a `i32, b `i32) `i32 {
+  >   c = a + b
+  >   if c > a
+  >     d = c * c
+  >     c = d
+  >   end
+  >   return c - b
+  > }
+  > .
+  $ $MAIN translate -s -l strings=100 stats.minc > /dev/null
+  strings: 51 of 100
+  strings-data: 32 of 104857600
+  arguments: 3 of 10485760
+  struct-fields: 2 of 65536
+  array-lengths: 1 of 65536
+  expressions: 13 of 10485760, in 'big'
+  locals: 4 of 1024, in 'big'
+  declarations: 1 structs, 1 consts, 2 fns
+  probes per string:
+    1: 11
+  work:
+    probes: 29
+    compared: 28 bytes
+    copied: 21 bytes
+    steps: 27
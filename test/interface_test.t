@@ -0,0 +1,73 @@
+The declarations of a set of source files can be written to an interface file,
+which translate then reads in place of the sources.
+
+  $ cat > lib.minc <<\.
+  > const width = 4
+  > struct point
+  >   x `i32,
+  >   cells `u8[width]*;
+  > fn point_add(a `point*, b `point*) `point* {
+  >   return a
+  > }
+  > .
+
+  $ cat > use.minc <<\.
+  > fn f(p `point*) `u64 {
+  >   q = point_add(p, p)
+  >   return q@`u64 + width@`u64
+  > }
+  > .
+
+  $ $MAIN interface lib.minc -o lib.minci
+  $ head -c 8 lib.minci
+  MINCINTF (no-eol)
+
+Functions only keep their signatures, so they become prototypes.
+
+  $ $MAIN translate lib.minci use.minc | tail -n +13
+  typedef struct point point;
+  struct point {
+    i32 x;
+    u8 (*cells)[4];
+  };
+  
+  point* point_add(point* a, point* b);
+  
+  u64 f(point* p) {
+    point* q;
+    q = point_add(p, p);
+    return (u64)q + (u64)4;
+  }
+
+Interfaces can also be used while writing another interface, but their
+declarations are not written again.
+
+  $ cat > more.minc <<\.
+  > fn point_twice(p `point*) `point*.
+  > .
+
+  $ $MAIN interface lib.minci more.minc -o more.minci
+  $ $MAIN translate more.minci | tail -n +13
+  point* point_twice(point* p);
+
+Standard input can be given as the last file, like with translate.
+
+  $ cat lib.minc | $MAIN interface - -o piped.minci
+  $ cmp lib.minci piped.minci
+  $ cat use.minc | $MAIN interface lib.minci - -o piped.minci
+  $ $MAIN translate piped.minci | tail -n +13
+  u64 f(point* p);
+  $ $MAIN interface - lib.minc -o piped.minci < use.minc
+  Standard input, given as '-', has to be the last file.
+  [1]
+
+The output file is required, and files that are not interfaces are rejected.
+
+  $ $MAIN interface lib.minc
+  Expected the interface file to be given with '-o'.
+  [1]
+
+  $ echo 'fn g().' > fake.minci
+  $ $MAIN translate fake.minci
+  The file "fake.minci" is not a valid interface file.
+  [1]
@@ -0,0 +1,74 @@
+The work of translating grows linearly with the size of the input, even for
+the kinds of input that are most likely to make it grow faster. Each kind is
+generated at three sizes, each twice the one before, and each count of work
+that '-s' reports may grow at most 2.2 times from one size to the next.
+Counting work instead of timing it keeps this from depending on the machine.
+
+  $ linear() {
+  >   for n in $2 $(($2 * 2)) $(($2 * 4)); do
+  >     awk -v n=$n "BEGIN { $1 }" > input.minc
+  >     $MAIN translate -s input.minc 2>&1 > /dev/null | awk '/^  (probes|compared|copied|steps):/ { printf "%s ", $2 }'
+  >     echo
+  >   done | awk '{ for (i = 1; i <= NF; i++) { if (NR > 1 && $i > 2.2 * last[i] + 100) bad = 1; last[i] = $i } } END { print bad ? "superlinear" : "linear" }'
+  > }
+
+Long chains of operators of alternating precedence, and of casts.
+
+  $ linear 'printf "fn f(a `i32, b `i32) `i32 {\n  return a"; for (i = 0; i < n; i++) printf " %s b@`i32", (i % 2 ? "+" : "*"); print "\n}"' 1000
+  linear
+  $ linear 'printf "fn f(a `i32, b `i32) `i32 {\n  return a"; for (i = 0; i < n; i++) printf " %s b", (i % 2 ? "+" : "-"); print "\n}"' 1000
+  linear
+  $ linear 'printf "fn f(a `i32) `i64 {\n  return a"; for (i = 0; i < n; i++) printf "@`i64@`i32"; print "@`i64\n}"' 1000
+  linear
+
+Many local variables in scope at once, and many that go in and out of scope,
+some of them with their types found from long expressions.
+
+  $ linear 'print "fn f(a `i32) `i32 {"; for (i = 0; i < n; i++) printf "  v%06d = a\n", i; print "  return v000000\n}"' 200
+  linear
+  $ linear 'print "fn f(a `i32) `i32 {"; for (i = 0; i < n; i++) printf "  if a\n    v%06d = a + a + a + a - a - a - a\n  end\n", i; print "  return a\n}"' 1000
+  linear
+
+Deeply nested parentheses, calls and blocks. The C code for nested blocks is
+indented, so it grows faster than the input, up to the limit on how deeply
+blocks can nest, but the work of translating it does not.
+
+  $ linear 'printf "fn g(x `i32) `i32.\nfn f(a `i32) `i32 {\n  return "; for (i = 0; i < n; i++) printf "(a + "; printf "a"; for (i = 0; i < n; i++) printf ")"; print "\n}"' 1000
+  linear
+  $ linear 'printf "fn g(x `i32) `i32.\nfn f(a `i32) `i32 {\n  return "; for (i = 0; i < n; i++) printf "g("; printf "a"; for (i = 0; i < n; i++) printf ")"; print "\n}"' 1000
+  linear
+  $ linear 'print "fn f(a `i32) `i32 {"; for (i = 0; i < n; i++) printf "  if a\n  v%06d = a\n", i; for (i = 0; i < n; i++) print "  end"; print "  return a\n}"' 200
+  linear
+
+Many names that differ only at the end, after a long common prefix, and
+many short names that differ in every character.
+
+  $ linear 'for (i = 0; i < n; i++) printf "fn a_long_common_prefix_for_all_of_the_names_%06d().\n", i' 5000
+  linear
+  $ linear 'for (i = 0; i < n; i++) printf "fn %c%c%c%c().\n", 97 + i % 26, 97 + int(i / 26) % 26, 97 + int(i / 676) % 26, 97 + int(i / 17576) % 26' 5000
+  linear
+
+Names whose hashes land in the same slot are the known worst case, which is
+not linear. The hashmap uses linear probing, so the k-th of n such names is
+found after k probes, and each of the two lookups of every name, once while
+prescanning and once while translating, takes n(n + 1)/2 probes in total.
+With '-l strings=1024' there are 2048 slots, so only the low 11 bits of the
+FNV-1a hash pick the slot, and the script below computes just those, with
+the offset basis and prime taken modulo 2048, to find 200 names that all land
+in slot 0. The probes come to exactly 2 * 200 * 201 / 2 and no more.
+
+  $ cat > storm.awk <<\.
+  > function xor(a, b,   r, bit) { r = 0; for (bit = 1; bit < 256; bit *= 2) if ((int(a / bit) + int(b / bit)) % 2) r += bit; return r }
+  > function step(h, c) { return ((h - h % 256 + xor(h % 256, c)) * 403) % 2048 }
+  > BEGIN {
+  >   h = step(1477, 110)
+  >   for (a = 97; a < 123; a++) { ha = step(h, a)
+  >   for (b = 97; b < 123; b++) { hb = step(ha, b)
+  >   for (c = 97; c < 123; c++) { hc = step(hb, c)
+  >   for (d = 97; d < 123 && found < n; d++) if (step(hc, d) == 0) { printf "fn n%c%c%c%c().\n", a, b, c, d; found++ } } } }
+  > }
+  > .
+  $ awk -v n=200 -f storm.awk > storm.minc
+  $ $MAIN translate -s -l strings=1024 storm.minc 2>&1 > /dev/null | grep -e '^  129-256:' -e '^  probes:'
+    129-256: 72
+    probes: 40200
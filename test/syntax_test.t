@@ -1,4 +1,4 @@
-  $ test() { cat > bad.minc; $MAIN translate bad.minc; }
+  $ test() { cat > bad.minc; $MAIN translate bad.minc -o bad.c; }
 
 STRUCTS
 
@@ -99,6 +99,12 @@ FUNCTIONS
                   ^
   [1]
 
+  $ awk 'BEGIN { print "fn many(a0 `i32,"; for (i = 1; i < 256; i++) print "  a" i " `i32,"; print "  z `i32)." }' | test
+  bad.minc:256:4: Functions can't have more than 255 arguments.
+  256 |   a255 `i32,
+          ^
+  [1]
+
   $ test <<\.
   > fn abc() {
   >   test = 5u8
@@ -199,9 +205,15 @@ Operator expressions.
   >   y = x + 1i32 - 10i32
   > }
   > .
-  bad.minc:2:17: Expected statement or '}'.
-  2 |   y = x + 1i32 - 10i32
-                     ^
+
+  $ test <<\.
+  > fn f(x `i32) {
+  >   y = x + 1i32 *
+  > }
+  > .
+  bad.minc:3:2: Expected identifier, number literal, or '('.
+  3 | }
+      ^
   [1]
 
   $ test <<\.
@@ -216,6 +228,22 @@ Operator expressions.
   > }
   > .
 
+Long runs of whitespace, identifier characters and operator characters are
+skipped in bulk without losing track of the location.
+
+  $ test <<\.
+  > fn f(x `i32) {
+  > 
+  > 
+  >                                           y = x ++++++++++++++++++++++++++++++++++++++ 1i32
+  >                                           if not_a_variable_but_a_rather_long_identifier
+  > }
+  > .
+  bad.minc:5:47: Unknown variable 'not_a_variable_but_a_rather_long_identifier'.
+  5 |                                           if not_a_variable_but_a_rather_long_identifier
+                                                   ^
+  [1]
+
 Function with return type.
 
   $ test <<\.
@@ -287,6 +315,61 @@ Arrays sizes can be named constants.
   >   y `u8[length];
   > .
 
+Constants and array sizes can be expressions of literals and other
+constants, which have to stay within what can be evaluated while translating.
+
+  $ test <<\.
+  > const length = 1000
+  > const half = length / 2 + 1u16
+  > struct x
+  >   y `u8[half * 2][length % 7],
+  >   z `u8[(half << 1)@`u32];
+  > .
+
+  $ test <<\.
+  > fn f() `u8.
+  > const length = f()
+  > .
+  bad.minc:2:17: Functions can't be called in constant expressions.
+  2 | const length = f()
+                     ^
+  [1]
+
+  $ test <<\.
+  > const length = 10 / (5 - 5)
+  > .
+  bad.minc:1:17: Division by zero in constant expression.
+  1 | const length = 10 / (5 - 5)
+                     ^
+  [1]
+
+  $ test <<\.
+  > const length = 0i32 - 1i32
+  > .
+  bad.minc:1:17: Constant expressions can't have negative values.
+  1 | const length = 0i32 - 1i32
+                     ^
+  [1]
+
+  $ test <<\.
+  > const length = 1u8 << 8
+  > .
+  bad.minc:1:17: Shifts in constant expressions have to be by less than the width of the type.
+  1 | const length = 1u8 << 8
+                     ^
+  [1]
+
+A constant ends with its line.
+
+  $ test <<\.
+  > const length = 1 +
+  >   2
+  > .
+  bad.minc:2:3: Expected literal or named integer constant.
+  2 |   2
+       ^
+  [1]
+
 TYPES
 
 Named types.
@@ -0,0 +1,127 @@
+With '-j', files are translated by several threads at once, and the output is
+the same as when they are translated one after another.
+
+  $ cat > a.minc <<\.
+  > const width = 4
+  > struct pair left `i32, right `i32[width];
+  > fn add(x `i32, y `i32) `i32 {
+  >   return x + y
+  > }
+  > .
+
+  $ cat > b.minc <<\.
+  > fn add(a `i32, b `i32) `i32.
+  > fn twice(x `i32) `i32 {
+  >   return add(x, x)
+  > }
+  > .
+
+  $ cat > c.minc <<\.
+  > fn four(x `i32) `i32 {
+  >   return twice(twice(x)) * width@`i32
+  > }
+  > .
+
+  $ $MAIN translate a.minc b.minc c.minc -o serial.c
+  $ tail -n +13 serial.c
+  typedef struct pair pair;
+  struct pair {
+    i32 left;
+    i32 right[4];
+  };
+  
+  i32 add(i32 x, i32 y) {
+    return x + y;
+  }
+  
+  i32 add(i32 a, i32 b);
+  
+  i32 twice(i32 x) {
+    return add(x, x);
+  }
+  
+  i32 four(i32 x) {
+    return twice(twice(x)) * (i32)4;
+  }
+  $ $MAIN translate -j 1 a.minc b.minc c.minc -o parallel.c && cmp serial.c parallel.c
+  $ $MAIN translate -j 2 a.minc b.minc c.minc -o parallel.c && cmp serial.c parallel.c
+  $ $MAIN translate -j 8 a.minc b.minc c.minc -o parallel.c && cmp serial.c parallel.c
+
+A file can use what the files after it declare, and the output is still the
+same as without '-j'. Of several errors, the one in the earliest file is
+reported.
+
+  $ $MAIN translate c.minc a.minc b.minc -o serial.c
+  $ $MAIN translate -j 2 c.minc a.minc b.minc -o parallel.c && cmp serial.c parallel.c
+  $ tail -n +13 parallel.c | head -n 6
+  i32 twice(i32 x);
+  
+  i32 four(i32 x) {
+    return twice(twice(x)) * (i32)4;
+  }
+  
+
+  $ cat > bad.minc <<\.
+  > fn bad() `i32 {
+  >   return missing()
+  > }
+  > .
+
+  $ $MAIN translate -j 2 a.minc bad.minc c.minc > /dev/null
+  bad.minc:2:11: Unknown function 'missing'.
+  2 |   return missing()
+               ^
+  [1]
+
+A large file is split into chunks, which are translated by different threads.
+Each chunk gets its own prototypes for the functions it calls before they are
+declared.
+
+  $ awk 'BEGIN { for (i = 0; i < 40000; i++) printf "fn f%d() `i32 {\n  return last()\n}\n", i; print "fn last() `i32 {\n  return 0i32\n}" }' > large.minc
+  $ $MAIN translate large.minc -o serial.c
+  $ $MAIN translate -j 3 large.minc -o parallel.c && cmp serial.c parallel.c
+  $ grep -c 'last(void);' serial.c
+  2
+
+Declarations of the same name in different files have to agree, apart from
+the names of arguments.
+
+  $ echo 'fn add(x `u8, y `i32) `i32.' > other.minc
+  $ $MAIN translate -j 2 a.minc other.minc > /dev/null
+  The declarations of 'add' in "a.minc" and "other.minc" do not agree, which is only allowed without '-j'.
+  [1]
+
+  $ $MAIN translate -j 0 a.minc
+  Expected a number of threads from 1 to 256 after '-j'.
+  [1]
+  $ $MAIN translate -j 2 -c t.cache a.minc
+  The '-c' and '-j' options can't be used together.
+  [1]
+
+Threads intern the names they meet at the same time, so names that are
+declared and called in every file race to be added. The output doesn't depend
+on which thread wins, and neither does the number of strings counted by '-s'.
+
+  $ for f in 1 2 3 4 5 6 7 8; do
+  >   awk -v f=$f 'BEGIN {
+  >     print "fn shared(x `i32) `i32."
+  >     for (i = 0; i < 2000; i++) printf "fn g%d_%d(v%d `i32) `i32 {\n  w%d = shared(v%d)\n  return common%d(w%d)\n}\n", f, i, i, i, i, i % 400, i
+  >     for (i = f - 1; i < 400; i += 8) printf "fn common%d(x `i32) `i32 {\n  return x\n}\n", i
+  >   }' > race$f.minc
+  > done
+  $ $MAIN translate -j 1 -s race*.minc -o race1.c 2> race1.txt
+  $ $MAIN translate -j 2 -s race*.minc -o race2.c 2> race2.txt && cmp race1.c race2.c
+  $ $MAIN translate -j 8 -s race*.minc -o race8.c 2> race8.txt && cmp race1.c race8.c
+  $ head -n 2 race1.txt | tee counts.txt
+  strings: 20443 of 1048576
+  strings-data: 144801 of 104857600
+  $ head -n 2 race2.txt | cmp - counts.txt
+  $ head -n 2 race8.txt | cmp - counts.txt
+
+The main thread sets up its own thread-local variables, so a statically linked
+build, which gets no help from a dynamic loader, works too.
+
+  $ gcc -s -O2 -nostdlib -static -fno-builtin -std=c99 -z noexecstack $TEST_DIR/../src/main.S $TEST_DIR/../src/main.c -o static
+  $ $MAIN translate a.minc b.minc c.minc -o serial.c
+  $ ./static translate a.minc b.minc c.minc -o static.c && cmp serial.c static.c
+  $ ./static translate -j 3 large.minc -o static.c && cmp parallel.c static.c
@@ -0,0 +1,342 @@
+Every translation starts with typedefs for the primitive types.
+
+  $ : > empty.minc
+
+  $ $MAIN translate empty.minc
+  typedef signed char i8;
+  typedef unsigned char u8;
+  typedef signed short i16;
+  typedef unsigned short u16;
+  typedef signed int i32;
+  typedef unsigned int u32;
+  typedef signed long i64;
+  typedef unsigned long u64;
+  typedef unsigned long size;
+  typedef float f32;
+  typedef double f64;
+
+The rest of these tests skip past the preamble.
+
+  $ translate() { cat > t.minc; $MAIN translate t.minc -o t.c && tail -n +13 t.c; }
+
+STRUCTS
+
+Array and pointer modifiers apply from left to right, so u8*[3] is an array of
+pointers and u8[3]* is a pointer to an array.
+
+  $ translate <<\.
+  > const width = 4
+  > struct grid
+  >   cells `u8[width][2],
+  >   rows `u8*[3],
+  >   row `u8[3]*,
+  >   next `grid*;
+  > .
+  typedef struct grid grid;
+  struct grid {
+    u8 cells[2][4];
+    u8* rows[3];
+    u8 (*row)[3];
+    grid* next;
+  };
+
+The values of constants and the lengths of arrays are expressions, which are
+evaluated while translating. Literals keep to the width and signedness of
+their type, and named constants and digits without a suffix take the type of
+what they are combined with.
+
+  $ translate <<\.
+  > const width = 4 * (3 + 2)
+  > const wrapped = 200u8 + 100u8
+  > const signed = (0i32 - 7i32) / 2i32 + 10i32
+  > const flags = (width > 16) | (wrapped == 44) << 1
+  > struct table
+  >   cells `u8[width / 2][width + 1],
+  >   rows `u8*[wrapped - signed]*;
+  > fn f(x `u64) `u64 {
+  >   switch x
+  >   case width - 1
+  >     return x@`u8[flags + 1]*
+  >   end
+  >   return signed
+  > }
+  > .
+  typedef struct table table;
+  struct table {
+    u8 cells[21][10];
+    u8* (*rows)[37];
+  };
+  
+  u64 f(u64 x) {
+    switch (x) {
+      case 19: {
+        return (u8 (*)[4])x;
+      } break;
+    }
+    return 7;
+  }
+
+FUNCTIONS
+
+Functions without a body become prototypes.
+
+  $ translate <<\.
+  > fn f(x `i32) `void*.
+  > fn g().
+  > .
+  void* f(i32 x);
+  
+  void g(void);
+
+Functions and constants can be used before they are declared. A function
+that is called before it is declared gets a prototype in front of the first
+function in the file that calls it.
+
+  $ translate <<\.
+  > fn f(cells `u8[size]*) `i32 {
+  >   return g(1i32) + g(2i32)
+  > }
+  > fn h() `i32 {
+  >   return g(size@`i32)
+  > }
+  > fn g(x `i32) `i32 {
+  >   return x
+  > }
+  > const size = 3
+  > .
+  i32 g(i32 x);
+  
+  i32 f(u8 (*cells)[3]) {
+    return g((i32)1) + g((i32)2);
+  }
+  
+  i32 h(void) {
+    return g((i32)3);
+  }
+  
+  i32 g(i32 x) {
+    return x;
+  }
+
+Local variables are declared at the start of the block they are introduced
+in, with the type of their initial value.
+
+  $ translate <<\.
+  > fn f(x `i32) `i64 {
+  >   y = x@`i64 + 007i64
+  >   if x == 0i32
+  >     z = 1u8
+  >     y = z@`i64
+  >   end
+  >   return y`i64
+  > }
+  > .
+  i64 f(i32 x) {
+    i64 y;
+    y = (i64)x + (i64)7l;
+    if (x == (i32)0) {
+      u8 z;
+      z = (u8)1;
+      y = (i64)z;
+    }
+    return y;
+  }
+
+An 'if' directly after 'else' continues the chain, so one 'end' closes it.
+
+  $ translate <<\.
+  > fn sign(x `i32) `i32 {
+  >   if x < 0i32
+  >     return 0i32 - 1i32
+  >   else if x == 0i32
+  >     return 0i32
+  >   else
+  >     return 1i32
+  >   end
+  > }
+  > .
+  i32 sign(i32 x) {
+    if (x < (i32)0) {
+      return (i32)0 - (i32)1;
+    } else if (x == (i32)0) {
+      return (i32)0;
+    } else {
+      return (i32)1;
+    }
+  }
+
+Cases do not fall through. Constants are substituted by value.
+
+  $ translate <<\.
+  > const one = 1
+  > const huge = 5000000000
+  > fn log(x `u64).
+  > fn f(x `u64) {
+  >   switch x
+  >   case 0
+  >     log(huge)
+  >   case one
+  >     while x > 0u64
+  >       x = x - 1u64
+  >     end
+  >   end
+  > }
+  > .
+  void log(u64 x);
+  
+  void f(u64 x) {
+    switch (x) {
+      case 0: {
+        log(5000000000ul);
+      } break;
+      case 1: {
+        while (x > (u64)0ul) {
+          x = x - (u64)1ul;
+        }
+      } break;
+    }
+  }
+
+Blocks that are still open at the end of the function are closed.
+
+  $ translate <<\.
+  > fn f(x `u8) {
+  >   while x
+  >     x = x - 1u8
+  > }
+  > .
+  void f(u8 x) {
+    while (x) {
+      x = x - (u8)1;
+    }
+  }
+
+Operators follow the precedence of C, and a run of the same operator is kept as
+one chain. Groups are not kept, so nested operators are always parenthesized.
+
+  $ translate <<\.
+  > fn f(a `u32, b `u32, c `u32) `u32 {
+  >   x = a + b + c * a * b - c % 7u32
+  >   y = ((a + b)) * (c - (a - b)) == x & a | b ^ c
+  >   return (a - b)@`u64@`u32 / (x << 2u32 >> 1u32)
+  > }
+  > .
+  u32 f(u32 a, u32 b, u32 c) {
+    u32 x;
+    u32 y;
+    x = (a + b + (c * a * b)) - (c % (u32)7);
+    y = ((((a + b) * (c - (a - b))) == x) & a) | (b ^ c);
+    return (u32)(u64)(a - b) / ((x << (u32)2) >> (u32)1);
+  }
+
+Deeply nested expressions are parsed without recursion.
+
+  $ { echo 'fn f(x `u32) `u32 {'; printf '  return '; printf '(%.0s' $(seq 100000); printf x; printf ')%.0s' $(seq 100000); echo; echo '}'; } > t.minc
+  $ $MAIN translate t.minc -o t.c && tail -n 3 t.c
+  u32 f(u32 x) {
+    return x;
+  }
+
+Local variables go out of scope at the end of their block, so the same name can
+be declared again in a later block, and arguments stay visible throughout.
+
+  $ translate <<\.
+  > fn f(x `u8) `u8 {
+  >   if x
+  >     y = x
+  >     x = y
+  >   else
+  >     y = 1u16
+  >   end
+  >   y = 2i32
+  >   return x
+  > }
+  > .
+  u8 f(u8 x) {
+    i32 y;
+    if (x) {
+      u8 y;
+      y = x;
+      x = y;
+    } else {
+      u16 y;
+      y = (u16)1;
+    }
+    y = (i32)2;
+    return x;
+  }
+
+  $ translate <<\.
+  > fn f(x `u8) {
+  >   while x
+  >     y = x
+  >   end
+  >   x = y
+  > }
+  > .
+  t.minc:5:8: Unknown variable 'y'.
+  5 |   x = y
+            ^
+  [1]
+
+Keywords that close or continue a block must match an open one.
+
+  $ translate <<\.
+  > fn f() {
+  >   end
+  > }
+  > .
+  t.minc:2:6: Found 'end' outside of a block.
+  2 |   end
+          ^
+  [1]
+
+  $ translate <<\.
+  > fn f(x `u8) {
+  >   while x
+  >   else
+  >   end
+  > }
+  > .
+  t.minc:3:7: Found 'else' without a matching 'if'.
+  3 |   else
+           ^
+  [1]
+
+  $ translate <<\.
+  > fn f() {
+  >   case 1
+  > }
+  > .
+  t.minc:2:7: Found 'case' outside of a 'switch'.
+  2 |   case 1
+           ^
+  [1]
+
+Functions can take many arguments.
+
+  $ awk 'BEGIN { printf "fn sum("; for (i = 0; i < 19; i++) printf "a%d `u8, ", i; print "z `u8) `u8.\nfn g() `u8 {"; printf "  return sum("; for (i = 0; i < 19; i++) printf "%du8, ", i; print "19u8)\n}" }' | translate
+  u8 sum(u8 a0, u8 a1, u8 a2, u8 a3, u8 a4, u8 a5, u8 a6, u8 a7, u8 a8, u8 a9, u8 a10, u8 a11, u8 a12, u8 a13, u8 a14, u8 a15, u8 a16, u8 a17, u8 a18, u8 z);
+  
+  u8 g(void) {
+    return sum((u8)0, (u8)1, (u8)2, (u8)3, (u8)4, (u8)5, (u8)6, (u8)7, (u8)8, (u8)9, (u8)10, (u8)11, (u8)12, (u8)13, (u8)14, (u8)15, (u8)16, (u8)17, (u8)18, (u8)19);
+  }
+
+The output is valid C89.
+
+  $ translate <<\. > /dev/null
+  > struct pair
+  >   a `i32,
+  >   b `i32*;
+  > fn first(p `pair*) `i32.
+  > fn f(p `pair*, n `u32) `u32 {
+  >   total = 0u32
+  >   while n > 0u32
+  >     total = total + first(p)@`u32
+  >     n = n - 1u32
+  >   end
+  >   return total
+  > }
+  > .
+
+  $ cc -std=c89 -pedantic-errors -fsyntax-only t.c